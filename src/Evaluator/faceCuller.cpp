@@ -0,0 +1,199 @@
+#include <faceCuller.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+
+namespace {
+	// the axis every face of Shapes::cube is perpendicular to and the direction it faces
+	struct FaceAxis {
+		int axis;
+		float sign;
+	};
+
+	constexpr FaceAxis FACE_AXES[FaceCuller::FACE_COUNT]{
+		{ 2, -1.0f },	// back
+		{ 2,  1.0f },	// front
+		{ 0, -1.0f },	// left
+		{ 0,  1.0f },	// right
+		{ 1, -1.0f },	// bottom
+		{ 1,  1.0f },	// top
+	};
+
+	// returns a mask of the faces of the cube around a point that lie inside the cube of a neighbour
+	// offset away. A face is as wide as the cube, so it only fits if the neighbour is (nearly) aligned
+	// with the point in the plane of the face and no more than one cube edge away along its normal
+	unsigned char containedFaces(const glm::vec3& offset, float halfSize, float tolerance) {
+		bool alignedX{ std::abs(offset.x) <= tolerance };
+		bool alignedY{ std::abs(offset.y) <= tolerance };
+		bool alignedZ{ std::abs(offset.z) <= tolerance };
+		// most neighbours are not aligned along any two axes
+		if (static_cast<int>(alignedX) + static_cast<int>(alignedY) + static_cast<int>(alignedZ) < 2) {
+			return 0;
+		}
+
+		// bits in the order of FACE_AXES, the negative side first
+		auto sides{ [halfSize](float along, int negative) {
+			float edge{ 2.0f * halfSize };
+			return static_cast<unsigned char>(((along <= 0.0f && along >= -edge) << negative) | ((along >= 0.0f && along <= edge) << (negative + 1)));
+		} };
+		unsigned char mask{ 0 };
+		if (alignedY && alignedZ) {
+			mask |= sides(offset.x, FaceCuller::left);
+		}
+		if (alignedX && alignedZ) {
+			mask |= sides(offset.y, FaceCuller::bottom);
+		}
+		if (alignedX && alignedY) {
+			mask |= sides(offset.z, FaceCuller::back);
+		}
+		return mask;
+	}
+}
+
+unsigned long long FaceCuller::FaceLists::visible() const {
+	unsigned long long total{ 0 };
+	for (unsigned int count : counts) {
+		total += count;
+	}
+	return total;
+}
+
+FaceCuller::FaceLists FaceCuller::update(const MorphState& state, const SurfaceGrid& grid, float t, glm::vec3 cameraPosition, unsigned int* indices,
+	FrameArena& arena) {
+	JobSystem& jobs{ m_evaluator.getJobs() };
+	int grain{ std::max(1, grid.rows / static_cast<int>(jobs.getThreadCount() * 4)) };
+	int chunkCount{ (grid.rows + grain - 1) / grain };
+
+	// a transition needs the target surface too, sized with the rest so the first transition doesn't allocate
+	m_points.resize(grid.size());
+	m_targetPoints.resize(grid.size());
+	m_masks.resize(grid.size());
+	m_chunks.assign(chunkCount, ChunkCounts{});
+
+	// the cube centres, blended the same way as mixMat4 in position.vert
+	m_evaluator.evaluate(state.from, grid, t, m_points.data());
+	if (state.isTransition()) {
+		m_evaluator.evaluate(state.to, grid, t, m_targetPoints.data());
+		float weight{ state.weight() };
+		jobs.parallelFor(grid.rows, grain, [&](int rowBegin, int rowEnd) {
+			for (int i{ rowBegin * grid.columns }; i < rowEnd * grid.columns; ++i) {
+				m_points[i] = m_points[i] * (1.0f - weight) + m_targetPoints[i] * weight;
+			}
+		});
+	}
+
+	// first pass: a mask of visible faces per sample and the number of visible faces per chunk
+	const float halfSize{ 0.5f * grid.cubeSize() };
+	const glm::vec3* points{ m_points.data() };
+	unsigned char* masks{ m_masks.data() };
+	const float tolerance{ m_tolerance * grid.cubeSize() };
+	jobs.parallelFor(grid.rows, grain, [&, points, masks, tolerance, cameraPosition](int rowBegin, int rowEnd) {
+		// counted locally, the byte stores into the masks would otherwise force the compiler to reload everything
+		ChunkCounts chunk{};
+		for (int row{ rowBegin }; row < rowEnd; ++row) {
+			for (int column{ 0 }; column < grid.columns; ++column) {
+				int i{ row * grid.columns + column };
+				const glm::vec3 point{ points[i] };
+
+				// faces pointing away from the camera
+				unsigned char mask{ 0 };
+				for (int f{ 0 }; f < FACE_COUNT; ++f) {
+					const FaceAxis& face{ FACE_AXES[f] };
+					if (face.sign * (cameraPosition[face.axis] - point[face.axis]) > halfSize) {
+						mask |= static_cast<unsigned char>(1 << f);
+					}
+				}
+
+				// faces inside the cube of one of the (up to) four neighbouring samples. The diagonal
+				// neighbours are about sqrt(2) grid steps away and too far to contain a whole face
+				unsigned char covered{ 0 };
+				if (column > 0) {
+					covered |= containedFaces(points[i - 1] - point, halfSize, tolerance);
+				}
+				if (column < grid.columns - 1) {
+					covered |= containedFaces(points[i + 1] - point, halfSize, tolerance);
+				}
+				if (row > 0) {
+					covered |= containedFaces(points[i - grid.columns] - point, halfSize, tolerance);
+				}
+				if (row < grid.rows - 1) {
+					covered |= containedFaces(points[i + grid.columns] - point, halfSize, tolerance);
+				}
+
+				for (int f{ 0 }; f < FACE_COUNT; ++f) {
+					unsigned char bit{ static_cast<unsigned char>(1 << f) };
+					if (!(mask & bit)) {
+						++chunk.backFacing;
+					}
+					else if (covered & bit) {
+						++chunk.covered;
+						mask &= static_cast<unsigned char>(~bit);
+					}
+					else {
+						++chunk.faces[f];
+					}
+				}
+				masks[i] = mask;
+			}
+		}
+		m_chunks[rowBegin / grain] = chunk;
+	});
+
+	// every face gets one contiguous list, every chunk writes its part of each list
+	FaceLists lists{};
+	unsigned int* chunkOffsets{ arena.allocate<unsigned int>(static_cast<std::size_t>(chunkCount) * FACE_COUNT) };
+	unsigned int offset{ 0 };
+	for (int f{ 0 }; f < FACE_COUNT; ++f) {
+		lists.offsets[f] = offset;
+		for (int chunk{ 0 }; chunk < chunkCount; ++chunk) {
+			chunkOffsets[chunk * FACE_COUNT + f] = offset;
+			offset += m_chunks[chunk].faces[f];
+		}
+		lists.counts[f] = offset - lists.offsets[f];
+	}
+	for (const ChunkCounts& chunk : m_chunks) {
+		lists.backFacing += chunk.backFacing;
+		lists.covered += chunk.covered;
+	}
+
+	// second pass: scatter the sample indices into the lists
+	jobs.parallelFor(grid.rows, grain, [&](int rowBegin, int rowEnd) {
+		unsigned int* cursor{ &chunkOffsets[(rowBegin / grain) * FACE_COUNT] };
+		for (int i{ rowBegin * grid.columns }; i < rowEnd * grid.columns; ++i) {
+			unsigned char mask{ m_masks[i] };
+			for (int f{ 0 }; mask != 0; ++f, mask >>= 1) {
+				if (mask & 1) {
+					indices[cursor[f]++] = static_cast<unsigned int>(i);
+				}
+			}
+		}
+	});
+
+	if (!state.isTransition()) {
+		SurfaceTotals& totals{ m_totals[static_cast<int>(state.from)] };
+		++totals.updates;
+		totals.faces += static_cast<unsigned long long>(grid.size()) * FACE_COUNT;
+		totals.backFacing += lists.backFacing;
+		totals.covered += lists.covered;
+	}
+	return lists;
+}
+
+void FaceCuller::printSummary() {
+	for (int s{ 0 }; s < Surfaces::COUNT; ++s) {
+		const SurfaceTotals& totals{ m_totals[s] };
+		if (totals.updates == 0) {
+			continue;
+		}
+		double faces{ static_cast<double>(totals.faces) };
+		std::cout << "| FACES: " << std::setw(9) << Surfaces::name(static_cast<Surfaces::Surface>(s))
+			<< std::fixed << std::setprecision(1)
+			<< " | " << 100.0 * (totals.backFacing + totals.covered) / faces << "% of triangles removed"
+			<< " (" << 100.0 * totals.backFacing / faces << "% back-facing, "
+			<< 100.0 * totals.covered / faces << "% covered by a neighbour)"
+			<< " over " << totals.updates << " updates\n";
+		std::cout << std::defaultfloat;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,147 @@
+#include <frameArena.h>
+
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <new>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+namespace {
+	constexpr std::size_t HUGE_PAGE_SIZE{ std::size_t{ 2 } << 20 };
+
+	std::size_t roundUp(std::size_t value, std::size_t multiple) {
+		return (value + multiple - 1) / multiple * multiple;
+	}
+}
+
+FrameArena::~FrameArena() {
+	destroy();
+}
+
+bool FrameArena::create(std::size_t capacity, bool hugePages) {
+	destroy();
+	// every region starts on a huge page, so none of them shares one with its neighbour
+	m_capacity = roundUp(capacity, hugePages ? HUGE_PAGE_SIZE : ALIGNMENT);
+	std::size_t size{ m_capacity * FRAMES_IN_FLIGHT };
+
+#ifdef __linux__
+	if (hugePages) {
+		void* memory{ mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0) };
+		if (memory != MAP_FAILED) {
+			m_memory = static_cast<unsigned char*>(memory);
+			m_backing = Backing::hugePages;
+		}
+		else {
+			// no huge pages reserved on this machine, ask for transparent ones instead
+			memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+			if (memory != MAP_FAILED) {
+#ifdef MADV_HUGEPAGE
+				madvise(memory, size, MADV_HUGEPAGE);
+#endif
+				m_memory = static_cast<unsigned char*>(memory);
+				m_backing = Backing::transparentHugePages;
+			}
+		}
+	}
+#endif
+	if (m_memory == nullptr) {
+		m_memory = static_cast<unsigned char*>(::operator new(size, std::align_val_t{ ALIGNMENT }, std::nothrow));
+		m_backing = Backing::heap;
+	}
+	if (m_memory == nullptr) {
+		std::cerr << "| ERROR::FRAME_ARENA: Failed to reserve " << size << " bytes\n";
+		m_backing = Backing::none;
+		return false;
+	}
+	m_reserved = size;
+
+	// fault every page in now rather than in the middle of a frame
+	std::memset(m_memory, 0, size);
+	for (int i{ 0 }; i < FRAMES_IN_FLIGHT; ++i) {
+		m_regions[i].memory = m_memory + i * m_capacity;
+		m_regions[i].used = 0;
+	}
+	m_current = 0;
+	return true;
+}
+
+void FrameArena::destroy() {
+	for (Region& region : m_regions) {
+		m_reset(region);
+		region = Region{};
+	}
+	if (m_memory == nullptr) {
+		return;
+	}
+#ifdef __linux__
+	if (m_backing == Backing::hugePages || m_backing == Backing::transparentHugePages) {
+		munmap(m_memory, m_reserved);
+	}
+#endif
+	if (m_backing == Backing::heap) {
+		::operator delete(m_memory, std::align_val_t{ ALIGNMENT });
+	}
+	m_memory = nullptr;
+	m_reserved = 0;
+	m_backing = Backing::none;
+}
+
+void FrameArena::beginFrame() {
+	m_current = (m_current + 1) % FRAMES_IN_FLIGHT;
+	m_reset(m_regions[m_current]);
+}
+
+void* FrameArena::allocate(std::size_t size, std::size_t alignment) {
+	Region& region{ m_regions[m_current] };
+	std::size_t offset{ roundUp(region.used, alignment) };
+	if (region.memory != nullptr && offset + size <= m_capacity) {
+		region.used = offset + size;
+		m_peak = std::max(m_peak, region.used);
+		return region.memory + offset;
+	}
+
+	// too large for what is left, correct but slow
+	++m_overflows;
+	void* memory{ ::operator new(size, std::align_val_t{ ALIGNMENT }) };
+	region.overflow.push_back(memory);
+	return memory;
+}
+
+void FrameArena::printSummary() {
+	if (m_backing == Backing::none) {
+		return;
+	}
+	std::streamsize precision{ std::cout.precision() };
+	const char* backings[]{ "none", "huge pages", "transparent huge pages", "heap" };
+	std::cout << "| FRAME_ARENA: " << FRAMES_IN_FLIGHT << " x " << m_capacity / 1024 << " KB on " << backings[static_cast<int>(m_backing)]
+		<< ", at most " << std::fixed << std::setprecision(1) << static_cast<double>(m_peak) / 1024.0 << " KB used in a frame"
+		<< std::defaultfloat << std::setprecision(precision);
+	if (m_overflows > 0) {
+		std::cout << ", " << m_overflows << " allocations didn't fit and came from the heap";
+	}
+	std::cout << '\n';
+}
+
+std::size_t FrameArena::getCapacity() {
+	return m_capacity;
+}
+
+std::size_t FrameArena::getPeak() {
+	return m_peak;
+}
+
+FrameArena::Backing FrameArena::getBacking() {
+	return m_backing;
+}
+
+void FrameArena::m_reset(Region& region) {
+	for (void* memory : region.overflow) {
+		::operator delete(memory, std::align_val_t{ ALIGNMENT });
+	}
+	region.overflow.clear();
+	region.used = 0;
+}
\ No newline at end of file
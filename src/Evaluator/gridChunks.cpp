@@ -0,0 +1,32 @@
+#include <gridChunks.h>
+
+#include <algorithm>
+
+GridChunks::GridChunks(const SurfaceGrid& grid, int rowMultiple, int maxSamples) {
+	rowMultiple = std::max(1, rowMultiple);
+	int rows{ std::max(1, maxSamples / std::max(1, grid.columns)) };
+	m_rowsPerChunk = std::min(std::max(rowMultiple, rows / rowMultiple * rowMultiple), std::max(1, grid.rows));
+
+	for (int firstRow{ 0 }; firstRow < grid.rows; firstRow += m_rowsPerChunk) {
+		SurfaceGrid chunkGrid{ grid };
+		chunkGrid.rows = std::min(m_rowsPerChunk, grid.rows - firstRow);
+		chunkGrid.vStart = grid.vStart + static_cast<float>(firstRow) * grid.vStep;
+		m_chunks.push_back(Chunk{ chunkGrid, firstRow, firstRow * grid.columns });
+	}
+}
+
+const std::vector<GridChunks::Chunk>& GridChunks::getChunks() {
+	return m_chunks;
+}
+
+int GridChunks::getCount() {
+	return static_cast<int>(m_chunks.size());
+}
+
+int GridChunks::getRowsPerChunk() {
+	return m_rowsPerChunk;
+}
+
+int GridChunks::getMaxSamples() {
+	return m_chunks.empty() ? 0 : m_chunks.front().grid.size();
+}
\ No newline at end of file
@@ -0,0 +1,307 @@
+#include <instanceKernel.h>
+#include <simd.h>
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+
+using Simd::Float;
+
+namespace {
+	static_assert(InstanceKernel::GRAIN % Simd::WIDTH == 0, "a job has to start on a whole block");
+	// a block of Simd::WIDTH instances covers whole vectors, so blocks stay aligned once the first one is
+	static_assert(3 * sizeof(float) * Simd::WIDTH % Simd::ALIGNMENT == 0, "a block has to keep the alignment of the output");
+	static_assert(sizeof(std::int32_t) * Simd::WIDTH % Simd::ALIGNMENT == 0, "a block has to keep the alignment of the output");
+
+	// where x, y and z fall in the three vectors of a block of interleaved instances
+	struct Layout {
+		// 1 in the lanes that hold the component, 0 elsewhere
+		float x[3 * Simd::WIDTH]{};
+		float y[3 * Simd::WIDTH]{};
+		float z[3 * Simd::WIDTH]{};
+		// the index of the lane's instance within the block in the x lanes, 0 elsewhere
+		float column[3 * Simd::WIDTH]{};
+	};
+
+	Layout makeLayout() {
+		Layout layout{};
+		for (int i{ 0 }; i < 3 * Simd::WIDTH; ++i) {
+			int component{ i % 3 };
+			layout.x[i] = component == 0 ? 1.0f : 0.0f;
+			layout.y[i] = component == 1 ? 1.0f : 0.0f;
+			layout.z[i] = component == 2 ? 1.0f : 0.0f;
+			layout.column[i] = component == 0 ? static_cast<float>(i / 3) : 0.0f;
+		}
+		return layout;
+	}
+
+	const Layout LAYOUT{ makeLayout() };
+
+	glm::vec3 instance(int row, int column, int half, float time) {
+		return glm::vec3{ column - half, time, row - half };
+	}
+
+	// instances [begin, end) of the grid into output, which starts at instance first. begin - first is a multiple of Simd::WIDTH
+	template <bool Streaming>
+	void generateRange(int width, float time, glm::vec3* output, int first, int begin, int end) {
+		const int half{ width / 2 };
+		Float x[3]{}, y[3]{}, z[3]{}, column[3]{}, step[3]{};
+		for (int v{ 0 }; v < 3; ++v) {
+			x[v] = Simd::load(LAYOUT.x + v * Simd::WIDTH);
+			y[v] = Simd::load(LAYOUT.y + v * Simd::WIDTH);
+			z[v] = Simd::load(LAYOUT.z + v * Simd::WIDTH);
+			column[v] = Simd::load(LAYOUT.column + v * Simd::WIDTH);
+			step[v] = Simd::broadcast(static_cast<float>(Simd::WIDTH)) * x[v];
+		}
+
+		// the block whose first instance is at rowIndex, columnIndex, valid while the whole block is in that row
+		int rowIndex{ begin / width };
+		int columnIndex{ begin % width };
+		Float block[3]{};
+		auto startBlock{ [&] {
+			Float fixed{ Simd::broadcast(static_cast<float>(columnIndex - half)) };
+			Float rowValue{ Simd::broadcast(static_cast<float>(rowIndex - half)) };
+			Float timeValue{ Simd::broadcast(time) };
+			for (int v{ 0 }; v < 3; ++v) {
+				block[v] = Simd::mulAdd(fixed, x[v], Simd::mulAdd(rowValue, z[v], Simd::mulAdd(timeValue, y[v], column[v])));
+			}
+		} };
+		startBlock();
+
+		float* out{ &output[begin - first].x };
+		const int blockEnd{ begin + (end - begin) / Simd::WIDTH * Simd::WIDTH };
+		for (int i{ begin }; i < blockEnd; i += Simd::WIDTH, out += 3 * Simd::WIDTH) {
+			if (columnIndex + Simd::WIDTH <= width) {
+				for (int v{ 0 }; v < 3; ++v) {
+					if constexpr (Streaming) {
+						Simd::stream(out + v * Simd::WIDTH, block[v]);
+					}
+					else {
+						Simd::store(out + v * Simd::WIDTH, block[v]);
+					}
+					block[v] = block[v] + step[v];
+				}
+				columnIndex += Simd::WIDTH;
+				if (columnIndex == width) {
+					columnIndex = 0;
+					++rowIndex;
+					startBlock();
+				}
+				continue;
+			}
+
+			// the block runs into the next row, once per row: built one instance at a time
+			alignas(64) glm::vec3 wrapped[Simd::WIDTH];
+			for (int lane{ 0 }; lane < Simd::WIDTH; ++lane) {
+				int c{ columnIndex + lane };
+				wrapped[lane] = instance(rowIndex + c / width, c % width, half, time);
+			}
+			for (int v{ 0 }; v < 3; ++v) {
+				Float value{ Simd::load(&wrapped[0].x + v * Simd::WIDTH) };
+				if constexpr (Streaming) {
+					Simd::stream(out + v * Simd::WIDTH, value);
+				}
+				else {
+					Simd::store(out + v * Simd::WIDTH, value);
+				}
+			}
+			rowIndex += (columnIndex + Simd::WIDTH) / width;
+			columnIndex = (columnIndex + Simd::WIDTH) % width;
+			startBlock();
+		}
+
+		// the last few instances of the grid
+		for (int i{ blockEnd }; i < end; ++i) {
+			output[i - first] = instance(i / width, i % width, half, time);
+		}
+		if constexpr (Streaming) {
+			// the job is reported done after this, whoever waits for it has to see the stores
+			Simd::streamFence();
+		}
+	}
+
+	// a half float with the value of a whole number, exact up to 2048 in magnitude
+	std::uint32_t toHalf(int value) {
+		if (value == 0) {
+			return 0;
+		}
+		std::uint32_t bits{ std::bit_cast<std::uint32_t>(static_cast<float>(value)) };
+		std::uint32_t sign{ (bits >> 16) & 0x8000u };
+		std::uint32_t exponent{ ((bits >> 23) & 0xFFu) - 127u + 15u };
+		return sign | (exponent << 10) | ((bits >> 13) & 0x3FFu);
+	}
+
+	// one 16-bit half of an instance in a compact format, the column or the row
+	std::uint32_t encode(InstanceKernel::Format format, int index, int half) {
+		switch (format) {
+		case InstanceKernel::Format::short2:	return static_cast<std::uint16_t>(index - half);
+		case InstanceKernel::Format::half2:		return toHalf(index - half);
+		default:								return static_cast<std::uint32_t>(index);
+		}
+	}
+
+	std::int32_t encode(InstanceKernel::Format format, int row, int column, int half) {
+		return static_cast<std::int32_t>(encode(format, column, half) | encode(format, row, half) << 16);
+	}
+
+	// instances [begin, end) of the grid in a compact format into output, which starts at instance first. begin - first is a multiple of Simd::WIDTH
+	template <bool Streaming>
+	void generateCodes(InstanceKernel::Format format, int width, const std::int32_t* columnCodes, std::int32_t* output, int first, int begin,
+		int end) {
+		const int half{ width / 2 };
+		int rowIndex{ begin / width };
+		int columnIndex{ begin % width };
+		Simd::Int rowCode{ Simd::broadcastInt(static_cast<std::int32_t>(encode(format, rowIndex, half) << 16)) };
+
+		std::int32_t* out{ output + (begin - first) };
+		const int blockEnd{ begin + (end - begin) / Simd::WIDTH * Simd::WIDTH };
+		for (int i{ begin }; i < blockEnd; i += Simd::WIDTH, out += Simd::WIDTH) {
+			Simd::Int block{};
+			if (columnIndex + Simd::WIDTH <= width) {
+				block = Simd::loadInt(columnCodes + columnIndex) | rowCode;
+				columnIndex += Simd::WIDTH;
+			}
+			else {
+				// the block runs into the next row
+				alignas(64) std::int32_t wrapped[Simd::WIDTH];
+				for (int lane{ 0 }; lane < Simd::WIDTH; ++lane) {
+					int c{ columnIndex + lane };
+					wrapped[lane] = encode(format, rowIndex + c / width, c % width, half);
+				}
+				block = Simd::loadInt(wrapped);
+				rowIndex += (columnIndex + Simd::WIDTH) / width;
+				columnIndex = (columnIndex + Simd::WIDTH) % width;
+				rowCode = Simd::broadcastInt(static_cast<std::int32_t>(encode(format, rowIndex, half) << 16));
+			}
+			if constexpr (Streaming) {
+				Simd::streamInt(out, block);
+			}
+			else {
+				Simd::storeInt(out, block);
+			}
+			if (columnIndex == width) {
+				columnIndex = 0;
+				++rowIndex;
+				rowCode = Simd::broadcastInt(static_cast<std::int32_t>(encode(format, rowIndex, half) << 16));
+			}
+		}
+
+		for (int i{ blockEnd }; i < end; ++i) {
+			output[i - first] = encode(format, i / width, i % width, half);
+		}
+		if constexpr (Streaming) {
+			Simd::streamFence();
+		}
+	}
+}
+
+void InstanceKernel::generate(int gridWidth, float time, Format format, void* output) {
+	generate(gridWidth, time, format, output, 0, gridWidth * gridWidth);
+}
+
+void InstanceKernel::generate(int gridWidth, float time, Format format, void* output, int first, int count) {
+	// a mapped GL buffer is page aligned, a std::vector may not be aligned enough for streaming
+	bool aligned{ reinterpret_cast<std::uintptr_t>(output) % Simd::ALIGNMENT == 0 };
+
+	if (format == Format::float3) {
+		glm::vec3* instances{ static_cast<glm::vec3*>(output) };
+		m_jobs.parallelFor(count, GRAIN, [=](int begin, int end) {
+			if (aligned) {
+				generateRange<true>(gridWidth, time, instances, first, first + begin, first + end);
+			}
+			else {
+				generateRange<false>(gridWidth, time, instances, first, first + begin, first + end);
+			}
+		});
+		return;
+	}
+
+	// the codes of the columns only change with the grid, a row is them combined with the code of the row
+	if (m_codeWidth != gridWidth || m_codeFormat != format) {
+		m_columnCodes.resize(gridWidth);
+		for (int column{ 0 }; column < gridWidth; ++column) {
+			m_columnCodes[column] = static_cast<std::int32_t>(encode(format, column, gridWidth / 2));
+		}
+		m_codeWidth = gridWidth;
+		m_codeFormat = format;
+	}
+	const std::int32_t* columnCodes{ m_columnCodes.data() };
+	std::int32_t* codes{ static_cast<std::int32_t*>(output) };
+	m_jobs.parallelFor(count, GRAIN, [=](int begin, int end) {
+		if (aligned) {
+			generateCodes<true>(format, gridWidth, columnCodes, codes, first, first + begin, first + end);
+		}
+		else {
+			generateCodes<false>(format, gridWidth, columnCodes, codes, first, first + begin, first + end);
+		}
+	});
+}
+
+void InstanceKernel::generateScalar(int gridWidth, float time, Format format, void* output) {
+	const int half{ gridWidth / 2 };
+	for (int row{ 0 }; row < gridWidth; ++row) {
+		for (int column{ 0 }; column < gridWidth; ++column) {
+			int index{ row * gridWidth + column };
+			if (format == Format::float3) {
+				static_cast<glm::vec3*>(output)[index] = instance(row, column, half, time);
+			}
+			else {
+				static_cast<std::int32_t*>(output)[index] = encode(format, row, column, half);
+			}
+		}
+	}
+}
+
+double InstanceKernel::measureWriteBandwidth(std::size_t size) {
+	const int count{ static_cast<int>(std::max<std::size_t>(size / sizeof(Float), 1)) };
+	std::unique_ptr<Float[]> buffer{ std::make_unique<Float[]>(count) };
+	Float* memory{ buffer.get() };
+
+	// the first pass faults the pages in and isn't timed
+	double best{};
+	for (int pass{ 0 }; pass < 4; ++pass) {
+		auto start{ std::chrono::steady_clock::now() };
+		m_jobs.parallelFor(count, GRAIN, [=](int begin, int end) {
+			Float value{ Simd::broadcast(static_cast<float>(pass)) };
+			for (int i{ begin }; i < end; ++i) {
+				Simd::stream(reinterpret_cast<float*>(memory + i), value);
+			}
+			Simd::streamFence();
+		});
+		double seconds{ std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() };
+		if (pass > 0 && seconds > 0.0) {
+			best = std::max(best, static_cast<double>(count) * sizeof(Float) / seconds);
+		}
+	}
+	return best;
+}
+
+std::size_t InstanceKernel::instanceSize(Format format) {
+	return format == Format::float3 ? sizeof(glm::vec3) : sizeof(std::int32_t);
+}
+
+int InstanceKernel::maxGridWidth(Format format) {
+	// half floats hold every whole number up to 2048, the other formats are limited by the instance count fitting an int
+	return format == Format::half2 ? 4096 : 46340;
+}
+
+const char* InstanceKernel::formatName(Format format) {
+	switch (format) {
+	case Format::float3:	return "float3";
+	case Format::short2:	return "short2";
+	case Format::half2:		return "half2";
+	case Format::packed:	return "packed";
+	default:				return "unknown";
+	}
+}
+
+const char* InstanceKernel::shaderDefines(Format format) {
+	switch (format) {
+	case Format::short2:	return "#define INSTANCE_SHORT2\n";
+	case Format::half2:		return "#define INSTANCE_HALF2\n";
+	case Format::packed:	return "#define INSTANCE_PACKED\n";
+	default:				return "";
+	}
+}
\ No newline at end of file
@@ -0,0 +1,303 @@
+#include <jobSystem.h>
+
+namespace {
+	std::atomic<std::uint64_t> nextSerial{ 1 };
+
+	// the system the calling thread used last and its entry there, saves the search on every call
+	thread_local std::uint64_t cachedSerial{};
+	thread_local int cachedIndex{ -1 };
+}
+
+bool JobSystem::Deque::push(Job* job) {
+	std::int64_t bottom{ m_bottom.load(std::memory_order_relaxed) };
+	std::int64_t top{ m_top.load(std::memory_order_acquire) };
+	if (bottom - top >= JOB_CAPACITY) {
+		return false;
+	}
+	m_slots[bottom & (JOB_CAPACITY - 1)].store(job, std::memory_order_relaxed);
+	m_bottom.store(bottom + 1, std::memory_order_release);
+	return true;
+}
+
+JobSystem::Job* JobSystem::Deque::pop() {
+	std::int64_t bottom{ m_bottom.load(std::memory_order_relaxed) - 1 };
+	m_bottom.store(bottom, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	std::int64_t top{ m_top.load(std::memory_order_relaxed) };
+	if (top > bottom) {
+		// empty
+		m_bottom.store(bottom + 1, std::memory_order_relaxed);
+		return nullptr;
+	}
+	Job* job{ m_slots[bottom & (JOB_CAPACITY - 1)].load(std::memory_order_relaxed) };
+	if (top == bottom) {
+		// the last job, a thief may be taking it at the same time
+		if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+			job = nullptr;
+		}
+		m_bottom.store(bottom + 1, std::memory_order_relaxed);
+	}
+	return job;
+}
+
+JobSystem::Job* JobSystem::Deque::steal() {
+	std::int64_t top{ m_top.load(std::memory_order_acquire) };
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	std::int64_t bottom{ m_bottom.load(std::memory_order_acquire) };
+	if (top >= bottom) {
+		return nullptr;
+	}
+	Job* job{ m_slots[top & (JOB_CAPACITY - 1)].load(std::memory_order_relaxed) };
+	if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+		return nullptr;
+	}
+	return job;
+}
+
+JobSystem::JobSystem(unsigned int threadCount)
+	: m_serial{ nextSerial.fetch_add(1, std::memory_order_relaxed) }
+{
+	if (threadCount == 0) {
+		threadCount = std::max(1u, std::thread::hardware_concurrency());
+	}
+	// the thread submitting work is one of the threads
+	m_workerCount = std::min(threadCount, static_cast<unsigned int>(MAX_THREADS - MAX_EXTERNAL_THREADS)) - 1;
+	for (unsigned int i{ 0 }; i < m_workerCount; ++i) {
+		Thread* thread{ new Thread{} };
+		thread->random = i + 1;
+		m_threads[i].store(thread, std::memory_order_relaxed);
+	}
+	m_threadCount.store(static_cast<int>(m_workerCount), std::memory_order_release);
+	for (unsigned int i{ 0 }; i < m_workerCount; ++i) {
+		m_workers.emplace_back(&JobSystem::m_workerLoop, this, static_cast<int>(i));
+	}
+}
+
+JobSystem::~JobSystem() {
+	m_stop.store(true, std::memory_order_seq_cst);
+	m_epoch.fetch_add(1, std::memory_order_seq_cst);
+	m_epoch.notify_all();
+	for (std::thread& worker : m_workers) {
+		worker.join();
+	}
+	int count{ m_threadCount.load(std::memory_order_acquire) };
+	for (int i{ 0 }; i < count; ++i) {
+		delete m_threads[i].load(std::memory_order_relaxed);
+	}
+}
+
+void JobSystem::wait(Counter& counter) {
+	Thread* thread{ m_currentThread() };
+	while (counter.m_pending.load(std::memory_order_acquire) > 0) {
+		Job* job{ thread != nullptr ? m_find(*thread) : nullptr };
+		if (job != nullptr) {
+			m_execute(job);
+		}
+		else {
+			// the remaining jobs are running elsewhere
+			std::this_thread::yield();
+		}
+	}
+	// the last job reaches zero while holding the lock, once it is free the counter isn't touched anymore and may go away
+	std::lock_guard<std::mutex> lock{ counter.m_mutex };
+}
+
+unsigned int JobSystem::getThreadCount() {
+	return m_workerCount + 1;
+}
+
+void JobSystem::m_workerLoop(int index) {
+	Thread& thread{ *m_threads[index].load(std::memory_order_acquire) };
+	{
+		std::lock_guard<std::mutex> lock{ m_registerMutex };
+		thread.id = std::this_thread::get_id();
+	}
+	cachedSerial = m_serial;
+	cachedIndex = index;
+
+	while (true) {
+		Job* job{ m_find(thread) };
+		if (job != nullptr) {
+			m_execute(job);
+			continue;
+		}
+
+		// a push after this load changes the epoch, so the wait below returns at once instead of missing it
+		unsigned int epoch{ m_epoch.load(std::memory_order_seq_cst) };
+		job = m_find(thread);
+		if (job != nullptr) {
+			m_execute(job);
+			continue;
+		}
+		if (m_stop.load(std::memory_order_relaxed)) {
+			return;
+		}
+		m_sleeping.fetch_add(1, std::memory_order_seq_cst);
+		m_epoch.wait(epoch, std::memory_order_seq_cst);
+		m_sleeping.fetch_sub(1, std::memory_order_relaxed);
+	}
+}
+
+JobSystem::Thread* JobSystem::m_currentThread() {
+	if (cachedSerial == m_serial) {
+		return cachedIndex >= 0 ? m_threads[cachedIndex].load(std::memory_order_acquire) : nullptr;
+	}
+
+	std::thread::id id{ std::this_thread::get_id() };
+	std::lock_guard<std::mutex> lock{ m_registerMutex };
+	int count{ m_threadCount.load(std::memory_order_relaxed) };
+	int index{ -1 };
+	// a worker of this system lands here after it has used another system
+	for (int i{ 0 }; i < count; ++i) {
+		if (m_threads[i].load(std::memory_order_relaxed)->id == id) {
+			index = i;
+		}
+	}
+	if (index < 0 && count < static_cast<int>(m_workerCount) + MAX_EXTERNAL_THREADS) {
+		Thread* thread{ new Thread{} };
+		thread->id = id;
+		thread->random = static_cast<unsigned int>(count) + 1;
+		m_threads[count].store(thread, std::memory_order_release);
+		m_threadCount.store(count + 1, std::memory_order_release);
+		index = count;
+	}
+	cachedSerial = m_serial;
+	cachedIndex = index;
+	return index >= 0 ? m_threads[index].load(std::memory_order_relaxed) : nullptr;
+}
+
+JobSystem::Job* JobSystem::m_find(Thread& thread) {
+	Job* job{ thread.deque.pop() };
+	if (job != nullptr) {
+		return job;
+	}
+
+	// steal from the other threads, starting at a random one so the thieves spread out
+	int count{ m_threadCount.load(std::memory_order_acquire) };
+	thread.random ^= thread.random << 13;
+	thread.random ^= thread.random >> 17;
+	thread.random ^= thread.random << 5;
+	int start{ static_cast<int>(thread.random % static_cast<unsigned int>(count)) };
+	for (int i{ 0 }; i < count; ++i) {
+		Thread* victim{ m_threads[(start + i) % count].load(std::memory_order_acquire) };
+		if (victim == nullptr || victim == &thread) {
+			continue;
+		}
+		job = victim->deque.steal();
+		if (job != nullptr) {
+			return job;
+		}
+	}
+	return nullptr;
+}
+
+JobSystem::Job* JobSystem::m_allocate(Thread* thread) {
+	if (thread == nullptr) {
+		return nullptr;
+	}
+	Job& job{ thread->jobs[thread->nextJob % JOB_CAPACITY] };
+	if (!job.finished.load(std::memory_order_acquire)) {
+		return nullptr;
+	}
+	++thread->nextJob;
+	job.finished.store(false, std::memory_order_relaxed);
+	job.counter = nullptr;
+	job.next = nullptr;
+	return &job;
+}
+
+void JobSystem::m_push(Thread* thread, Job* job) {
+	if (thread == nullptr || !thread->deque.push(job)) {
+		m_execute(job);
+		return;
+	}
+	m_epoch.fetch_add(1, std::memory_order_seq_cst);
+	if (m_sleeping.load(std::memory_order_seq_cst) > 0) {
+		m_epoch.notify_one();
+	}
+}
+
+void JobSystem::m_execute(Job* job) {
+	job->function(*this, *job);
+	Counter* counter{ job->counter };
+	// after this the slot may be reused by the thread that allocated it
+	job->finished.store(true, std::memory_order_release);
+	if (counter != nullptr) {
+		m_finish(*counter);
+	}
+}
+
+void JobSystem::m_submit(Job* job, Counter* dependency) {
+	if (dependency != nullptr) {
+		std::lock_guard<std::mutex> lock{ dependency->m_mutex };
+		if (dependency->m_pending.load(std::memory_order_acquire) > 0) {
+			job->next = dependency->m_dependents;
+			dependency->m_dependents = job;
+			return;
+		}
+	}
+	m_push(m_currentThread(), job);
+}
+
+void JobSystem::m_finish(Counter& counter) {
+	// only the decrement to zero takes the lock, so the jobs of a large loop don't contend for it
+	int pending{ counter.m_pending.load(std::memory_order_relaxed) };
+	while (pending > 1) {
+		if (counter.m_pending.compare_exchange_weak(pending, pending - 1, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+			return;
+		}
+	}
+
+	Job* dependents{};
+	{
+		std::lock_guard<std::mutex> lock{ counter.m_mutex };
+		if (counter.m_pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+			dependents = counter.m_dependents;
+			counter.m_dependents = nullptr;
+		}
+	}
+	Thread* thread{ dependents != nullptr ? m_currentThread() : nullptr };
+	while (dependents != nullptr) {
+		Job* next{ dependents->next };
+		m_push(thread, dependents);
+		dependents = next;
+	}
+}
+
+void JobSystem::m_runRange(JobSystem& system, Job& job) {
+	system.m_runRange(*std::launder(reinterpret_cast<Range*>(job.storage)));
+}
+
+void JobSystem::m_runRange(Range range) {
+	Loop& loop{ *range.loop };
+	Thread* thread{ m_currentThread() };
+	while (range.rowEnd - range.rowBegin > 1 || range.columnEnd - range.columnBegin > 1) {
+		// halve the longer side, keep the first half and leave the second to be stolen
+		Range half{ range };
+		if (range.rowEnd - range.rowBegin >= range.columnEnd - range.columnBegin) {
+			int middle{ range.rowBegin + (range.rowEnd - range.rowBegin) / 2 };
+			range.rowEnd = middle;
+			half.rowBegin = middle;
+		}
+		else {
+			int middle{ range.columnBegin + (range.columnEnd - range.columnBegin) / 2 };
+			range.columnEnd = middle;
+			half.columnBegin = middle;
+		}
+
+		Job* job{ m_allocate(thread) };
+		if (job == nullptr) {
+			// no free slot, do that half here right away
+			m_runRange(half);
+			continue;
+		}
+		new (job->storage) Range{ half };
+		job->function = &JobSystem::m_runRange;
+		job->counter = &loop.counter;
+		loop.counter.m_pending.fetch_add(1, std::memory_order_relaxed);
+		m_push(thread, job);
+	}
+
+	loop.invoke(loop.task, range.rowBegin * loop.rowGrain, std::min((range.rowBegin + 1) * loop.rowGrain, loop.rows),
+		range.columnBegin * loop.columnGrain, std::min((range.columnBegin + 1) * loop.columnGrain, loop.columns));
+}
\ No newline at end of file
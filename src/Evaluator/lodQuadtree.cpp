@@ -0,0 +1,164 @@
+#include <lodQuadtree.h>
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <utility>
+
+LodQuadtree::LodQuadtree(const SurfaceGrid& grid, int maxNodes, float pixelError)
+	: m_grid{ grid }
+	, m_pixelError{ pixelError }
+{
+	// the root patch covers the whole grid
+	int steps{ std::max(grid.columns, grid.rows) - 1 };
+	while ((PATCH_QUADS << m_rootLevel) < steps) {
+		++m_rootLevel;
+	}
+	// the nodes don't overlap, so even at full density there are no more than the leaves that touch the grid
+	long long leaves{ static_cast<long long>((grid.columns - 1 + PATCH_QUADS - 1) / PATCH_QUADS) * ((grid.rows - 1 + PATCH_QUADS - 1) / PATCH_QUADS) };
+	m_maxNodes = static_cast<int>(std::clamp(leaves, 1ll, static_cast<long long>(std::max(1, maxNodes))));
+	m_ranges.resize(m_rootLevel + 2);
+	m_levelNodes.resize(m_rootLevel + 1);
+
+	// a split is only kept while the budget has room for its children, so no level ever has more candidates than that,
+	// plus the up to four children of the split that is taken back
+	m_nodes.reserve(m_maxNodes);
+	m_candidates.reserve(static_cast<std::size_t>(m_maxNodes) + 4);
+	m_children.reserve(static_cast<std::size_t>(m_maxNodes) + 4);
+}
+
+const std::vector<LodQuadtree::Node>& LodQuadtree::select(const MorphState& state, float t, const glm::vec3& cameraPosition,
+	const glm::mat4& viewProjection, float pixelsPerUnit) {
+	Frustum frustum{ viewProjection };
+	// level L has a vertex step of 2^L grid steps, which projects to the pixel error at this distance
+	for (std::size_t level{ 0 }; level < m_ranges.size(); ++level) {
+		m_ranges[level] = m_grid.uStep * static_cast<float>(1 << level) * pixelsPerUnit / m_pixelError;
+	}
+
+	m_nodes.clear();
+	m_children.clear();
+	m_samples = 0;
+	m_addChild(state, t, cameraPosition, frustum, m_rootLevel, 0, 0);
+	bool budgetReached{ false };
+	while (!m_children.empty()) {
+		std::swap(m_candidates, m_children);
+		m_children.clear();
+		// the nearest candidates of the level are split first, they are the ones the budget is for
+		std::sort(m_candidates.begin(), m_candidates.end(), [](const Candidate& a, const Candidate& b) { return a.distance < b.distance; });
+
+		for (std::size_t i{ 0 }; i < m_candidates.size(); ++i) {
+			const Candidate& candidate{ m_candidates[i] };
+			bool fineEnough{ candidate.level == 0 || candidate.distance >= m_ranges[candidate.level] };
+			if (!fineEnough) {
+				int level{ candidate.level - 1 };
+				int half{ PATCH_QUADS << level };
+				std::size_t childrenBefore{ m_children.size() };
+				m_addChild(state, t, cameraPosition, frustum, level, candidate.column, candidate.row);
+				m_addChild(state, t, cameraPosition, frustum, level, candidate.column + half, candidate.row);
+				m_addChild(state, t, cameraPosition, frustum, level, candidate.column, candidate.row + half);
+				m_addChild(state, t, cameraPosition, frustum, level, candidate.column + half, candidate.row + half);
+				// the nodes drawn if the children and every candidate left were drawn whole. Children off the grid or
+				// outside the frustum aren't added, so this counts exactly what the split costs
+				std::size_t committed{ m_nodes.size() + (m_candidates.size() - i - 1) + m_children.size() };
+				if (committed <= static_cast<std::size_t>(m_maxNodes)) {
+					continue;
+				}
+				m_children.resize(childrenBefore);
+			}
+			budgetReached = budgetReached || !fineEnough;
+			m_nodes.push_back(m_makeNode(candidate));
+			++m_levelNodes[candidate.level];
+			m_samples += m_ownedSamples(candidate);
+		}
+	}
+
+	++m_frames;
+	m_selectedNodes += m_nodes.size();
+	m_selectedSamples += m_samples;
+	m_maxSelected = std::max(m_maxSelected, static_cast<unsigned int>(m_nodes.size()));
+	m_budgetFrames += budgetReached ? 1 : 0;
+	return m_nodes;
+}
+
+void LodQuadtree::m_addChild(const MorphState& state, float t, const glm::vec3& cameraPosition, const Frustum& frustum, int level, int column,
+	int row) {
+	// the root is larger than the grid, the parts of it past the last sample are left out
+	if (column >= m_grid.columns - 1 || row >= m_grid.rows - 1) {
+		return;
+	}
+	int span{ PATCH_QUADS << level };
+	int columnEnd{ std::min(column + span, m_grid.columns - 1) };
+	int rowEnd{ std::min(row + span, m_grid.rows - 1) };
+	Interval u{ m_grid.uStart + static_cast<float>(column) * m_grid.uStep, m_grid.uStart + static_cast<float>(columnEnd) * m_grid.uStep };
+	Interval v{ m_grid.vStart + static_cast<float>(row) * m_grid.vStep, m_grid.vStart + static_cast<float>(rowEnd) * m_grid.vStep };
+	Surfaces::Bounds box{ Morph::bounds(state, u, v, Interval{ t }) };
+	if (!frustum.intersects(box)) {
+		return;
+	}
+
+	glm::vec3 closest{ glm::clamp(cameraPosition, box.min, box.max) };
+	m_children.push_back(Candidate{ level, column, row, glm::distance(cameraPosition, closest) });
+}
+
+LodQuadtree::Node LodQuadtree::m_makeNode(const Candidate& candidate) {
+	int level{ candidate.level };
+	float morphStart{ m_ranges[level] + (m_ranges[level + 1] - m_ranges[level]) * MORPH_START };
+	float morphEnd{ m_ranges[level + 1] };
+	if (level == m_rootLevel) {
+		// nothing to morph into, the range is too far away to reach
+		morphStart = 0.5f * std::numeric_limits<float>::max();
+		morphEnd = std::numeric_limits<float>::max();
+	}
+	return Node{ m_grid.uStart + static_cast<float>(candidate.column) * m_grid.uStep, m_grid.vStart + static_cast<float>(candidate.row) * m_grid.vStep,
+		m_grid.uStep * static_cast<float>(1 << level), morphStart, morphEnd, level };
+}
+
+long long LodQuadtree::m_ownedSamples(const Candidate& candidate) const {
+	int step{ 1 << candidate.level };
+	auto along{ [step](int start, int last) {
+		// steps up to the last sample, plus the last sample itself if no node comes after this one
+		int steps{ std::min(PATCH_QUADS, (last - start + step - 1) / step) };
+		return static_cast<long long>(steps) + (start + PATCH_QUADS * step >= last ? 1 : 0);
+	} };
+	return along(candidate.column, m_grid.columns - 1) * along(candidate.row, m_grid.rows - 1);
+}
+
+glm::vec2 LodQuadtree::getEnd() {
+	return glm::vec2{ m_grid.uStart + static_cast<float>(m_grid.columns - 1) * m_grid.uStep,
+		m_grid.vStart + static_cast<float>(m_grid.rows - 1) * m_grid.vStep };
+}
+
+void LodQuadtree::printSummary() {
+	if (m_frames == 0 || m_selectedNodes == 0) {
+		return;
+	}
+	std::streamsize precision{ std::cout.precision() };
+	double patches{ static_cast<double>(m_selectedNodes) / m_frames };
+	double vertices{ patches * patchVertices() };
+	std::cout << "| LOD: " << std::fixed << std::setprecision(1) << patches << " patches per frame, max " << m_maxSelected << " of "
+		<< m_maxNodes << " | " << vertices / 1000.0 << "k vertices drawn, on " << 100.0 * m_selectedSamples / m_frames / m_grid.size()
+		<< "% of the grid's samples"
+		<< " | budget reached in " << m_budgetFrames << " of " << m_frames << " frames\n";
+	if (m_budgetFrames > 0) {
+		std::cout << "| WARNING::LOD: the budget of " << m_maxNodes << " patches ran out in " << m_budgetFrames
+			<< " frames, parts of those missed the pixel error and may have had cracks\n";
+	}
+	std::cout << "| LOD: patches per level";
+	for (std::size_t level{ 0 }; level < m_levelNodes.size(); ++level) {
+		std::cout << (level == 0 ? " " : ", ") << level << ": " << 100.0 * m_levelNodes[level] / m_selectedNodes << '%';
+	}
+	std::cout << '\n' << std::defaultfloat << std::setprecision(precision);
+}
+
+int LodQuadtree::getMaxNodes() {
+	return m_maxNodes;
+}
+
+long long LodQuadtree::getSelectedSamples() {
+	return m_samples;
+}
+
+int LodQuadtree::getLevelCount() {
+	return m_rootLevel + 1;
+}
\ No newline at end of file
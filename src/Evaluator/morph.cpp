@@ -0,0 +1,51 @@
+#include <morph.h>
+
+#include <cmath>
+
+namespace Morph {
+	MorphState at(float time) {
+		// surfaces in the order they appear in the cycle, each phase ends with a transition to the next one
+		constexpr Surfaces::Surface order[]{
+			Surfaces::Surface::wave,
+			Surfaces::Surface::multiWave,
+			Surfaces::Surface::ripple,
+			Surfaces::Surface::sphere,
+			Surfaces::Surface::torus,
+		};
+
+		int second{ static_cast<int>(time) % static_cast<int>(CYCLE) };
+		int phase{ second / static_cast<int>(PHASE) };
+		MorphState state{ order[phase], order[phase], 0.0f };
+		if (second % static_cast<int>(PHASE) == static_cast<int>(PHASE) - 1) {
+			state.to = order[(phase + 1) % Surfaces::COUNT];
+			state.blend = time - std::floor(time);
+		}
+		return state;
+	}
+
+	glm::vec3 evaluate(const MorphState& state, float u, float v, float t) {
+		glm::vec3 from{ Surfaces::evaluate(state.from, u, v, t) };
+		if (!state.isTransition()) {
+			return from;
+		}
+		float weight{ state.weight() };
+		return from * (1.0f - weight) + Surfaces::evaluate(state.to, u, v, t) * weight;
+	}
+
+	Surfaces::Bounds bounds(const MorphState& state, Interval u, Interval v, Interval t) {
+		Surfaces::Bounds from{ Surfaces::bounds(state.from, u, v, t) };
+		if (!state.isTransition()) {
+			return from;
+		}
+		// mixMat4 blends every coordinate on its own with the smoothed weight
+		Interval weight{ smoothstep(Interval{ state.blend }) };
+		Surfaces::Bounds to{ Surfaces::bounds(state.to, u, v, t) };
+		Surfaces::Bounds blended{};
+		for (int i{ 0 }; i < 3; ++i) {
+			Interval coordinate{ mix(Interval{ from.min[i], from.max[i] }, Interval{ to.min[i], to.max[i] }, weight) };
+			blended.min[i] = coordinate.lo;
+			blended.max[i] = coordinate.hi;
+		}
+		return blended;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,372 @@
+#include <surfaceEvaluator.h>
+#include <simd.h>
+
+#include <algorithm>
+
+using Simd::Float;
+using Surfaces::Surface;
+
+namespace {
+	struct Point {
+		Float x;
+		Float y;
+		Float z;
+	};
+
+	const Float PI{ Simd::broadcast(Surfaces::PI) };
+
+	// the kernels below are the vector versions of the functions in surfaces.cpp
+	Point wave(Float u, Float v, Float t) {
+		return { u, Simd::sin(PI * (u + v + t)), v };
+	}
+
+	Point multiWave(Float u, Float v, Float t) {
+		Float y{ Simd::sin(PI * (u + Simd::broadcast(0.5f) * t)) };
+		y = Simd::mulAdd(Simd::broadcast(0.5f), Simd::sin(Simd::broadcast(2.0f) * PI * (v + t)), y);
+		y = y + Simd::sin(PI * (u + v + Simd::broadcast(0.25f) * t));
+		y = y * Simd::broadcast(1.0f / 2.5f);
+		return { u, y, v };
+	}
+
+	Point ripple(Float u, Float v, Float t) {
+		Float d{ Simd::sqrt(Simd::mulAdd(u, u, v * v)) };
+		Float y{ Simd::sin(PI * (Simd::broadcast(4.0f) * d - t)) };
+		y = y / Simd::mulAdd(Simd::broadcast(10.0f), d, Simd::broadcast(1.0f));
+		return { u, y, v };
+	}
+
+	Point sphere(Float u, Float v, Float t) {
+		Float r{ Simd::sin(PI * (Simd::broadcast(12.0f) * u + Simd::broadcast(8.0f) * v + t)) };
+		r = Simd::mulAdd(Simd::broadcast(0.1f), r, Simd::broadcast(0.9f));
+		Float sinV{}, cosV{};
+		Simd::sinCos(Simd::broadcast(0.5f) * PI * v, sinV, cosV);
+		Float sinU{}, cosU{};
+		Simd::sinCos(PI * u, sinU, cosU);
+		Float s{ r * cosV };
+		return { s * sinU, r * sinV, s * cosU };
+	}
+
+	Point torus(Float u, Float v, Float t) {
+		Float r1{ Simd::sin(PI * (Simd::broadcast(8.0f) * u + Simd::broadcast(0.5f) * t)) };
+		r1 = Simd::mulAdd(Simd::broadcast(0.1f), r1, Simd::broadcast(0.7f));
+		Float r2{ Simd::sin(PI * (Simd::broadcast(16.0f) * u + Simd::broadcast(8.0f) * v + Simd::broadcast(3.0f) * t)) };
+		r2 = Simd::mulAdd(Simd::broadcast(0.05f), r2, Simd::broadcast(0.15f));
+		Float sinV{}, cosV{};
+		Simd::sinCos(PI * v, sinV, cosV);
+		Float sinU{}, cosU{};
+		Simd::sinCos(PI * u, sinU, cosU);
+		Float s{ Simd::mulAdd(r2, cosV, Simd::broadcast(0.5f) + r1) };
+		return { s * sinU, r2 * sinV, s * cosU };
+	}
+
+	// Separable versions. columns() fills the u-only table entries of a
+	// column, rows() the v-only entries of a row (t is fixed per call), and
+	// combine() rebuilds the sample from them with multiply-adds only
+	struct WaveSeparable {
+		static constexpr int COLUMN_TABLES{ 3 };
+		static constexpr int ROW_TABLES{ 3 };
+
+		// sin(PI * (u + v + t)) = sin(PI * u) cos(PI * (v + t)) + cos(PI * u) sin(PI * (v + t))
+		static void columns(Float u, Float, Float* c) {
+			c[0] = u;
+			Simd::sinCos(PI * u, c[1], c[2]);
+		}
+		static void rows(Float v, Float t, Float* r) {
+			r[0] = v;
+			Simd::sinCos(PI * (v + t), r[1], r[2]);
+		}
+		static Point combine(const Float* c, const Float* r) {
+			return { c[0], Simd::mulAdd(c[1], r[2], c[2] * r[1]), r[0] };
+		}
+	};
+
+	struct MultiWaveSeparable {
+		static constexpr int COLUMN_TABLES{ 4 };
+		static constexpr int ROW_TABLES{ 4 };
+
+		// the first term only depends on u, the second only on v, the third is
+		// expanded like wave. The 1 / 2.5 is folded into the tables
+		static void columns(Float u, Float t, Float* c) {
+			const Float scale{ Simd::broadcast(1.0f / 2.5f) };
+			c[0] = u;
+			c[1] = scale * Simd::sin(PI * (u + Simd::broadcast(0.5f) * t));
+			Float sine{}, cosine{};
+			Simd::sinCos(PI * u, sine, cosine);
+			c[2] = scale * sine;
+			c[3] = scale * cosine;
+		}
+		static void rows(Float v, Float t, Float* r) {
+			r[0] = v;
+			r[1] = Simd::broadcast(0.5f / 2.5f) * Simd::sin(Simd::broadcast(2.0f) * PI * (v + t));
+			Simd::sinCos(PI * (v + Simd::broadcast(0.25f) * t), r[2], r[3]);
+		}
+		static Point combine(const Float* c, const Float* r) {
+			Float y{ Simd::mulAdd(c[2], r[3], c[1] + r[1]) };
+			return { c[0], Simd::mulAdd(c[3], r[2], y), r[0] };
+		}
+	};
+
+	struct SphereSeparable {
+		static constexpr int COLUMN_TABLES{ 4 };
+		static constexpr int ROW_TABLES{ 4 };
+
+		// sin(PI * (12u + 8v + t)) is expanded around 12 * PI * u and PI * (8v + t),
+		// every other factor already depends on u or v alone
+		static void columns(Float u, Float, Float* c) {
+			Simd::sinCos(Simd::broadcast(12.0f) * PI * u, c[0], c[1]);
+			Simd::sinCos(PI * u, c[2], c[3]);
+		}
+		static void rows(Float v, Float t, Float* r) {
+			Simd::sinCos(PI * (Simd::broadcast(8.0f) * v + t), r[0], r[1]);
+			Simd::sinCos(Simd::broadcast(0.5f) * PI * v, r[2], r[3]);
+		}
+		static Point combine(const Float* c, const Float* r) {
+			Float wave{ Simd::mulAdd(c[0], r[1], c[1] * r[0]) };
+			Float radius{ Simd::mulAdd(Simd::broadcast(0.1f), wave, Simd::broadcast(0.9f)) };
+			Float s{ radius * r[3] };
+			return { s * c[2], radius * r[2], s * c[3] };
+		}
+	};
+
+	struct TorusSeparable {
+		static constexpr int COLUMN_TABLES{ 5 };
+		static constexpr int ROW_TABLES{ 4 };
+
+		// r1 only depends on u, sin(PI * (16u + 8v + 3t)) is expanded around
+		// 16 * PI * u and PI * (8v + 3t). The 0.05 of r2 is folded into the tables
+		static void columns(Float u, Float t, Float* c) {
+			Float r1{ Simd::sin(PI * (Simd::broadcast(8.0f) * u + Simd::broadcast(0.5f) * t)) };
+			c[0] = Simd::mulAdd(Simd::broadcast(0.1f), r1, Simd::broadcast(0.5f + 0.7f));
+			Float sine{}, cosine{};
+			Simd::sinCos(Simd::broadcast(16.0f) * PI * u, sine, cosine);
+			c[1] = Simd::broadcast(0.05f) * sine;
+			c[2] = Simd::broadcast(0.05f) * cosine;
+			Simd::sinCos(PI * u, c[3], c[4]);
+		}
+		static void rows(Float v, Float t, Float* r) {
+			Simd::sinCos(PI * (Simd::broadcast(8.0f) * v + Simd::broadcast(3.0f) * t), r[0], r[1]);
+			Simd::sinCos(PI * v, r[2], r[3]);
+		}
+		static Point combine(const Float* c, const Float* r) {
+			Float r2{ Simd::mulAdd(c[1], r[1], Simd::mulAdd(c[2], r[0], Simd::broadcast(0.15f))) };
+			Float s{ Simd::mulAdd(r2, r[3], c[0]) };
+			return { s * c[3], r2 * r[2], s * c[4] };
+		}
+	};
+
+	// writes count lanes of p to sample index onwards. Full vectors are stored
+	// straight into the output, partial vectors and interleaved output go
+	// through a small buffer so nothing past the end of a row is written
+	void store(const Point& p, int index, int count, float* outX, float* outY, float* outZ, glm::vec3* outPoints) {
+		if (outPoints == nullptr && count == Simd::WIDTH) {
+			Simd::store(outX + index, p.x);
+			Simd::store(outY + index, p.y);
+			Simd::store(outZ + index, p.z);
+			return;
+		}
+
+		float x[Simd::WIDTH], y[Simd::WIDTH], z[Simd::WIDTH];
+		Simd::store(x, p.x);
+		Simd::store(y, p.y);
+		Simd::store(z, p.z);
+		for (int lane{ 0 }; lane < count; ++lane) {
+			if (outPoints != nullptr) {
+				outPoints[index + lane] = glm::vec3{ x[lane], y[lane], z[lane] };
+			}
+			else {
+				outX[index + lane] = x[lane];
+				outY[index + lane] = y[lane];
+				outZ[index + lane] = z[lane];
+			}
+		}
+	}
+
+	// evaluates rows [rowBegin, rowEnd) with the given kernel
+	template <Point (*Kernel)(Float, Float, Float)>
+	void evaluateRows(const SurfaceGrid& grid, float time, int rowBegin, int rowEnd,
+		float* outX, float* outY, float* outZ, glm::vec3* outPoints) {
+		const Float t{ Simd::broadcast(time) };
+		const Float uStep{ Simd::broadcast(grid.uStep) };
+		const Float lanes{ Simd::iota() };
+
+		for (int row{ rowBegin }; row < rowEnd; ++row) {
+			const Float v{ Simd::broadcast(grid.vStart + static_cast<float>(row) * grid.vStep) };
+			const int rowOffset{ row * grid.columns };
+
+			for (int column{ 0 }; column < grid.columns; column += Simd::WIDTH) {
+				Float u{ Simd::mulAdd(Simd::broadcast(static_cast<float>(column)) + lanes, uStep, Simd::broadcast(grid.uStart)) };
+				int count{ std::min(Simd::WIDTH, grid.columns - column) };
+				store(Kernel(u, v, t), rowOffset + column, count, outX, outY, outZ, outPoints);
+			}
+		}
+	}
+
+	void evaluateRows(Surface surface, const SurfaceGrid& grid, float t, int rowBegin, int rowEnd,
+		float* x, float* y, float* z, glm::vec3* points) {
+		switch (surface) {
+		case Surface::wave:			evaluateRows<wave>(grid, t, rowBegin, rowEnd, x, y, z, points); break;
+		case Surface::multiWave:	evaluateRows<multiWave>(grid, t, rowBegin, rowEnd, x, y, z, points); break;
+		case Surface::ripple:		evaluateRows<ripple>(grid, t, rowBegin, rowEnd, x, y, z, points); break;
+		case Surface::sphere:		evaluateRows<sphere>(grid, t, rowBegin, rowEnd, x, y, z, points); break;
+		case Surface::torus:		evaluateRows<torus>(grid, t, rowBegin, rowEnd, x, y, z, points); break;
+		default:					break;
+		}
+	}
+
+	// number of floats per column table, padded so the last vector load of a row stays inside it
+	int columnStride(const SurfaceGrid& grid) {
+		return (grid.columns + Simd::WIDTH - 1) / Simd::WIDTH * Simd::WIDTH;
+	}
+
+	// tables of the separable surface with the most of them
+	constexpr int MAX_TABLES{ 5 };
+
+	int rowStride(const SurfaceGrid& grid) {
+		return (grid.rows + Simd::WIDTH - 1) / Simd::WIDTH * Simd::WIDTH;
+	}
+
+	// fills table k of every column at columns[k * columnStride + column], likewise for rows
+	template <typename Separable>
+	void buildTables(const SurfaceGrid& grid, float time, std::vector<float>& columns, std::vector<float>& rows) {
+		const Float t{ Simd::broadcast(time) };
+		const Float lanes{ Simd::iota() };
+		const int columnSize{ columnStride(grid) };
+		const int rowSize{ rowStride(grid) };
+		static_assert(Separable::COLUMN_TABLES <= MAX_TABLES && Separable::ROW_TABLES <= MAX_TABLES, "raise MAX_TABLES");
+		// room for every surface on the first call, so switching surfaces never reallocates
+		columns.reserve(static_cast<std::size_t>(MAX_TABLES) * columnSize);
+		rows.reserve(static_cast<std::size_t>(MAX_TABLES) * rowSize);
+		columns.resize(static_cast<std::size_t>(Separable::COLUMN_TABLES) * columnSize);
+		rows.resize(static_cast<std::size_t>(Separable::ROW_TABLES) * rowSize);
+
+		Float entries[Separable::COLUMN_TABLES > Separable::ROW_TABLES ? Separable::COLUMN_TABLES : Separable::ROW_TABLES]{};
+		for (int column{ 0 }; column < columnSize; column += Simd::WIDTH) {
+			Float u{ Simd::mulAdd(Simd::broadcast(static_cast<float>(column)) + lanes, Simd::broadcast(grid.uStep), Simd::broadcast(grid.uStart)) };
+			Separable::columns(u, t, entries);
+			for (int k{ 0 }; k < Separable::COLUMN_TABLES; ++k) {
+				Simd::store(&columns[static_cast<std::size_t>(k) * columnSize + column], entries[k]);
+			}
+		}
+		for (int row{ 0 }; row < rowSize; row += Simd::WIDTH) {
+			Float v{ Simd::mulAdd(Simd::broadcast(static_cast<float>(row)) + lanes, Simd::broadcast(grid.vStep), Simd::broadcast(grid.vStart)) };
+			Separable::rows(v, t, entries);
+			for (int k{ 0 }; k < Separable::ROW_TABLES; ++k) {
+				Simd::store(&rows[static_cast<std::size_t>(k) * rowSize + row], entries[k]);
+			}
+		}
+	}
+
+	template <typename Separable>
+	void combineRows(const SurfaceGrid& grid, const float* columns, const float* rows, int rowBegin, int rowEnd,
+		float* outX, float* outY, float* outZ, glm::vec3* outPoints) {
+		const int columnSize{ columnStride(grid) };
+		const int rowSize{ rowStride(grid) };
+
+		for (int row{ rowBegin }; row < rowEnd; ++row) {
+			Float r[Separable::ROW_TABLES];
+			for (int k{ 0 }; k < Separable::ROW_TABLES; ++k) {
+				r[k] = Simd::broadcast(rows[k * rowSize + row]);
+			}
+			const int rowOffset{ row * grid.columns };
+
+			for (int column{ 0 }; column < grid.columns; column += Simd::WIDTH) {
+				Float c[Separable::COLUMN_TABLES];
+				for (int k{ 0 }; k < Separable::COLUMN_TABLES; ++k) {
+					c[k] = Simd::load(columns + k * columnSize + column);
+				}
+				int count{ std::min(Simd::WIDTH, grid.columns - column) };
+				store(Separable::combine(c, r), rowOffset + column, count, outX, outY, outZ, outPoints);
+			}
+		}
+	}
+
+	template <typename Separable>
+	void evaluateSeparable(JobSystem& jobs, int grain, const SurfaceGrid& grid, float t,
+		std::vector<float>& columns, std::vector<float>& rows, float* x, float* y, float* z, glm::vec3* points) {
+		// a couple of thousand table entries, not worth spreading over the threads
+		buildTables<Separable>(grid, t, columns, rows);
+		jobs.parallelFor(grid.rows, grain, [&](int rowBegin, int rowEnd) {
+			combineRows<Separable>(grid, columns.data(), rows.data(), rowBegin, rowEnd, x, y, z, points);
+		});
+	}
+}
+
+void SurfaceEvaluator::evaluate(Surface surface, const SurfaceGrid& grid, float t, float* x, float* y, float* z) {
+	m_evaluate(surface, grid, t, Output{ x, y, z, nullptr });
+}
+
+void SurfaceEvaluator::evaluate(Surface surface, const SurfaceGrid& grid, float t, glm::vec3* points) {
+	m_evaluate(surface, grid, t, Output{ nullptr, nullptr, nullptr, points });
+}
+
+void SurfaceEvaluator::evaluateRows(Surface surface, const SurfaceGrid& grid, float t, int rowBegin, int rowEnd,
+	float* x, float* y, float* z) {
+	::evaluateRows(surface, grid, t, rowBegin, rowEnd, x, y, z, nullptr);
+}
+
+bool SurfaceEvaluator::isSeparable(Surface surface) {
+	return surface != Surface::ripple;
+}
+
+const char* SurfaceEvaluator::getVectorUnit() {
+	return Simd::NAME;
+}
+
+int SurfaceEvaluator::getVectorWidth() {
+	return Simd::WIDTH;
+}
+
+bool SurfaceEvaluator::isVectorUnitSupported() {
+#if defined(__AVX2__) && defined(__FMA__) && (defined(__GNUC__) || defined(__clang__))
+	return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#elif defined(__AVX2__) && (defined(__GNUC__) || defined(__clang__))
+	return __builtin_cpu_supports("avx2");
+#else
+	// SSE2 is part of x86-64, MSVC builds have to be run where they were configured for
+	return true;
+#endif
+}
+
+unsigned int SurfaceEvaluator::getThreadCount() {
+	return m_jobs.getThreadCount();
+}
+
+JobSystem& SurfaceEvaluator::getJobs() {
+	return m_jobs;
+}
+
+SurfaceEvaluator::Method SurfaceEvaluator::getMethod() {
+	return m_method;
+}
+
+void SurfaceEvaluator::setMethod(Method method) {
+	m_method = method;
+}
+
+void SurfaceEvaluator::m_evaluate(Surface surface, const SurfaceGrid& grid, float t, const Output& output) {
+	// a few chunks per thread keeps the threads busy even if some get descheduled
+	int grain{ std::max(1, grid.rows / static_cast<int>(m_jobs.getThreadCount() * 4)) };
+
+	if (m_method == Method::separable && isSeparable(surface)) {
+		switch (surface) {
+		case Surface::wave:
+			evaluateSeparable<WaveSeparable>(m_jobs, grain, grid, t, m_columnTables, m_rowTables, output.x, output.y, output.z, output.points);
+			return;
+		case Surface::multiWave:
+			evaluateSeparable<MultiWaveSeparable>(m_jobs, grain, grid, t, m_columnTables, m_rowTables, output.x, output.y, output.z, output.points);
+			return;
+		case Surface::sphere:
+			evaluateSeparable<SphereSeparable>(m_jobs, grain, grid, t, m_columnTables, m_rowTables, output.x, output.y, output.z, output.points);
+			return;
+		case Surface::torus:
+			evaluateSeparable<TorusSeparable>(m_jobs, grain, grid, t, m_columnTables, m_rowTables, output.x, output.y, output.z, output.points);
+			return;
+		default:
+			break;
+		}
+	}
+
+	m_jobs.parallelFor(grid.rows, grain, [&](int rowBegin, int rowEnd) {
+		::evaluateRows(surface, grid, t, rowBegin, rowEnd, output.x, output.y, output.z, output.points);
+	});
+}
\ No newline at end of file
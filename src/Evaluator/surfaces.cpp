@@ -0,0 +1,129 @@
+#include <surfaces.h>
+
+#include <cmath>
+
+namespace {
+	// the formulas of position.vert for T = float (points) and T = Interval (bounds)
+	namespace Formulas {
+		using std::sin;
+		using std::cos;
+		using std::sqrt;
+		using Surfaces::PI;
+
+		inline float square(float x) { return x * x; }
+
+		template <typename T>
+		struct Point {
+			T x;
+			T y;
+			T z;
+		};
+
+		template <typename T>
+		Point<T> wave(T u, T v, T t) {
+			return { u, sin(PI * (u + v + t)), v };
+		}
+
+		template <typename T>
+		Point<T> multiWave(T u, T v, T t) {
+			T y{ sin(PI * (u + 0.5f * t)) };
+			y = y + 0.5f * sin(2.0f * PI * (v + t));
+			y = y + sin(PI * (u + v + 0.25f * t));
+			y = y * (1.0f / 2.5f);
+			return { u, y, v };
+		}
+
+		template <typename T>
+		Point<T> ripple(T u, T v, T t) {
+			T d{ sqrt(square(u) + square(v)) };
+			T y{ sin(PI * (4.0f * d - t)) };
+			y = y / (1.0f + 10.0f * d);
+			return { u, y, v };
+		}
+
+		template <typename T>
+		Point<T> sphere(T u, T v, T t) {
+			T r{ 0.9f + 0.1f * sin(PI * (12.0f * u + 8.0f * v + t)) };
+			T s{ r * cos(0.5f * PI * v) };
+			return { s * sin(PI * u), r * sin(PI * 0.5f * v), s * cos(PI * u) };
+		}
+
+		template <typename T>
+		Point<T> torus(T u, T v, T t) {
+			T r1{ 0.7f + 0.1f * sin(PI * (8.0f * u + 0.5f * t)) };
+			T r2{ 0.15f + 0.05f * sin(PI * (16.0f * u + 8.0f * v + 3.0f * t)) };
+			T s{ 0.5f + r1 + r2 * cos(PI * v) };
+			return { s * sin(PI * u), r2 * sin(PI * v), s * cos(PI * u) };
+		}
+	}
+
+	glm::vec3 toVec3(const Formulas::Point<float>& p) {
+		return glm::vec3{ p.x, p.y, p.z };
+	}
+
+	Surfaces::Bounds toBounds(const Formulas::Point<Interval>& p) {
+		return Surfaces::Bounds{ { p.x.lo, p.y.lo, p.z.lo }, { p.x.hi, p.y.hi, p.z.hi } };
+	}
+}
+
+namespace Surfaces {
+	glm::vec3 wave(float u, float v, float t) {
+		return toVec3(Formulas::wave(u, v, t));
+	}
+
+	glm::vec3 multiWave(float u, float v, float t) {
+		return toVec3(Formulas::multiWave(u, v, t));
+	}
+
+	glm::vec3 ripple(float u, float v, float t) {
+		return toVec3(Formulas::ripple(u, v, t));
+	}
+
+	glm::vec3 sphere(float u, float v, float t) {
+		return toVec3(Formulas::sphere(u, v, t));
+	}
+
+	glm::vec3 torus(float u, float v, float t) {
+		return toVec3(Formulas::torus(u, v, t));
+	}
+
+	glm::vec3 evaluate(Surface surface, float u, float v, float t) {
+		switch (surface) {
+		case Surface::wave:			return wave(u, v, t);
+		case Surface::multiWave:	return multiWave(u, v, t);
+		case Surface::ripple:		return ripple(u, v, t);
+		case Surface::sphere:		return sphere(u, v, t);
+		case Surface::torus:		return torus(u, v, t);
+		default:					return glm::vec3{ u, 1.0f, v };
+		}
+	}
+
+	const char* name(Surface surface) {
+		switch (surface) {
+		case Surface::wave:			return "wave";
+		case Surface::multiWave:	return "multiWave";
+		case Surface::ripple:		return "ripple";
+		case Surface::sphere:		return "sphere";
+		case Surface::torus:		return "torus";
+		default:					return "plane";
+		}
+	}
+
+	Bounds bounds(Surface surface, Interval u, Interval v, Interval t) {
+		switch (surface) {
+		case Surface::wave:			return toBounds(Formulas::wave(u, v, t));
+		case Surface::multiWave:	return toBounds(Formulas::multiWave(u, v, t));
+		case Surface::ripple:		return toBounds(Formulas::ripple(u, v, t));
+		case Surface::sphere:		return toBounds(Formulas::sphere(u, v, t));
+		case Surface::torus:		return toBounds(Formulas::torus(u, v, t));
+		default:					return Bounds{ { u.lo, 1.0f, v.lo }, { u.hi, 1.0f, v.hi } };
+		}
+	}
+}
+
+SurfaceGrid SurfaceGrid::instanceGrid(int width) {
+	// position.vert gets the spacing as gridStep in the frame data
+	float spacing{ 2.0f / static_cast<float>(width) };
+	float start{ static_cast<float>(-(width / 2)) * spacing };
+	return SurfaceGrid{ width, width, start, start, spacing, spacing };
+}
\ No newline at end of file
@@ -0,0 +1,59 @@
+#include <tessellationPatches.h>
+#include <frustum.h>
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+
+TessellationPatches::TessellationPatches(const SurfaceGrid& grid, int patches)
+	: m_grid{ grid }
+	, m_patches{ std::max(1, patches) }
+{
+	m_visible.reserve(static_cast<std::size_t>(m_patches) * m_patches);
+}
+
+const std::vector<unsigned int>& TessellationPatches::cull(const MorphState& state, float t, const glm::mat4& viewProjection) {
+	Frustum frustum{ viewProjection };
+	glm::vec4 domain{ getDomain() };
+	// position.vert places the patch corners on the same even steps across the domain
+	glm::vec2 patchSize{ (glm::vec2{ domain.z, domain.w } - glm::vec2{ domain.x, domain.y }) / static_cast<float>(m_patches) };
+
+	m_visible.clear();
+	for (int row{ 0 }; row < m_patches; ++row) {
+		for (int column{ 0 }; column < m_patches; ++column) {
+			Interval u{ domain.x + static_cast<float>(column) * patchSize.x, domain.x + static_cast<float>(column + 1) * patchSize.x };
+			Interval v{ domain.y + static_cast<float>(row) * patchSize.y, domain.y + static_cast<float>(row + 1) * patchSize.y };
+			if (frustum.intersects(Morph::bounds(state, u, v, Interval{ t }))) {
+				m_visible.push_back(static_cast<unsigned int>(row * m_patches + column));
+			}
+		}
+	}
+
+	++m_frames;
+	m_visiblePatches += m_visible.size();
+	return m_visible;
+}
+
+glm::vec4 TessellationPatches::getDomain() {
+	return glm::vec4{ m_grid.uStart, m_grid.vStart, m_grid.uStart + static_cast<float>(m_grid.columns - 1) * m_grid.uStep,
+		m_grid.vStart + static_cast<float>(m_grid.rows - 1) * m_grid.vStep };
+}
+
+void TessellationPatches::printSummary() {
+	if (m_frames == 0) {
+		return;
+	}
+	std::streamsize precision{ std::cout.precision() };
+	std::cout << "| TESSELLATION: " << std::fixed << std::setprecision(1)
+		<< 100.0 * m_visiblePatches / (static_cast<double>(getPatchCount()) * m_frames) << "% of " << getPatchCount()
+		<< " patches drawn over " << m_frames << " frames\n"
+		<< std::defaultfloat << std::setprecision(precision);
+}
+
+int TessellationPatches::getPatches() {
+	return m_patches;
+}
+
+int TessellationPatches::getPatchCount() {
+	return m_patches * m_patches;
+}
\ No newline at end of file
@@ -0,0 +1,101 @@
+#include <tileGrid.h>
+#include <frustum.h>
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+
+TileGrid::TileGrid(const SurfaceGrid& grid, int tileSize)
+	: m_grid{ grid }
+{
+	tileSize = std::max(1, tileSize);
+	unsigned int first{ 0 };
+	for (int rowBegin{ 0 }; rowBegin < grid.rows; rowBegin += tileSize) {
+		for (int columnBegin{ 0 }; columnBegin < grid.columns; columnBegin += tileSize) {
+			Tile tile{ columnBegin, std::min(columnBegin + tileSize, grid.columns), rowBegin, std::min(rowBegin + tileSize, grid.rows) };
+			unsigned int count{ static_cast<unsigned int>((tile.columnEnd - tile.columnBegin) * (tile.rowEnd - tile.rowBegin)) };
+			tile.instances = Range{ first, count };
+			first += count;
+			m_tiles.push_back(tile);
+		}
+	}
+	m_ranges.reserve(m_tiles.size());
+}
+
+std::vector<unsigned int> TileGrid::sampleOrder(std::size_t first, std::size_t count) const {
+	std::vector<unsigned int> samples{};
+	samples.reserve(count);
+	std::size_t end{ first + count };
+	for (const Tile& tile : m_tiles) {
+		std::size_t instance{ tile.instances.first };
+		// the tiles are in instance order, the ones before the range are skipped whole
+		if (instance + tile.instances.count <= first) {
+			continue;
+		}
+		if (instance >= end) {
+			break;
+		}
+		for (int row{ tile.rowBegin }; row < tile.rowEnd; ++row) {
+			for (int column{ tile.columnBegin }; column < tile.columnEnd; ++column, ++instance) {
+				if (instance >= first && instance < end) {
+					samples.push_back(static_cast<unsigned int>(row * m_grid.columns + column));
+				}
+			}
+		}
+	}
+	return samples;
+}
+
+const std::vector<TileGrid::Range>& TileGrid::cull(const MorphState& state, float t, const glm::mat4& viewProjection) {
+	Frustum frustum{ viewProjection };
+	// the bounds are for the cube centres, the cubes reach half an edge further
+	glm::vec3 halfCube{ 0.5f * m_grid.cubeSize() };
+
+	m_ranges.clear();
+	m_lastVisibleTiles = 0;
+	for (const Tile& tile : m_tiles) {
+		float uMin{ m_grid.uStart + static_cast<float>(tile.columnBegin) * m_grid.uStep };
+		float uMax{ m_grid.uStart + static_cast<float>(tile.columnEnd - 1) * m_grid.uStep };
+		float vMin{ m_grid.vStart + static_cast<float>(tile.rowBegin) * m_grid.vStep };
+		float vMax{ m_grid.vStart + static_cast<float>(tile.rowEnd - 1) * m_grid.vStep };
+		Surfaces::Bounds box{ Morph::bounds(state, Interval{ uMin, uMax }, Interval{ vMin, vMax }, Interval{ t }) };
+		box.min -= halfCube;
+		box.max += halfCube;
+		if (!frustum.intersects(box)) {
+			continue;
+		}
+
+		++m_lastVisibleTiles;
+		m_drawnInstances += tile.instances.count;
+		if (!m_ranges.empty() && m_ranges.back().first + m_ranges.back().count == tile.instances.first) {
+			m_ranges.back().count += tile.instances.count;
+		}
+		else {
+			m_ranges.push_back(tile.instances);
+		}
+	}
+
+	++m_frames;
+	m_visibleTiles += m_lastVisibleTiles;
+	return m_ranges;
+}
+
+void TileGrid::printSummary() {
+	if (m_frames == 0) {
+		return;
+	}
+	double tiles{ static_cast<double>(m_tiles.size()) * m_frames };
+	double instances{ static_cast<double>(m_grid.size()) * m_frames };
+	std::cout << "| TILES: " << std::fixed << std::setprecision(1)
+		<< 100.0 * m_visibleTiles / tiles << "% of " << m_tiles.size() << " tiles and "
+		<< 100.0 * m_drawnInstances / instances << "% of the instances drawn over " << m_frames << " frames\n"
+		<< std::defaultfloat;
+}
+
+int TileGrid::getTileCount() {
+	return static_cast<int>(m_tiles.size());
+}
+
+unsigned int TileGrid::getLastVisibleTiles() {
+	return m_lastVisibleTiles;
+}
\ No newline at end of file
@@ -0,0 +1,43 @@
+#pragma once
+
+// Debug check that the render loop runs without heap allocations once it
+// has warmed up. Per-frame scratch memory comes from a FrameArena instead
+//
+//   CHECK_NO_ALLOCATIONS("frame", armed);   while armed, operator new in the enclosing scope aborts
+//   ALLOW_ALLOCATIONS();                    lifts the check for the rest of the enclosing scope, for the
+//                                           few driver calls that allocate on every use
+//
+// The check covers the calling thread only, including what the GL driver
+// allocates on it through operator new. It replaces the global operator
+// new and delete, so the macros compile to nothing unless the build defines
+// ENABLE_ALLOCATION_CHECK (debug builds and --alloccheck=y)
+
+#ifdef ENABLE_ALLOCATION_CHECK
+#define ALLOCATION_CHECK_CONCAT_INNER(a, b) a##b
+#define ALLOCATION_CHECK_CONCAT(a, b) ALLOCATION_CHECK_CONCAT_INNER(a, b)
+#define CHECK_NO_ALLOCATIONS(where, armed) AllocationCheck::Scope ALLOCATION_CHECK_CONCAT(allocationScope, __LINE__){ where, armed }
+#define ALLOW_ALLOCATIONS() AllocationCheck::Scope ALLOCATION_CHECK_CONCAT(allocationScope, __LINE__){ nullptr, true }
+#else
+#define CHECK_NO_ALLOCATIONS(where, armed) ((void)0)
+#define ALLOW_ALLOCATIONS() ((void)0)
+#endif
+
+namespace AllocationCheck {
+	// frames the render loop runs with a new program before the check starts
+	static inline constexpr int WARMUP_FRAMES{ 3 };
+
+	// while alive and armed, any heap allocation on the calling thread prints where it happened and aborts
+	class Scope {
+	private:
+		const char* m_previous{};
+
+	public:
+		// constructor, where has to outlive the scope, a string literal. Armed with where nullptr the scope
+		// allows allocations again until it ends
+		Scope(const char* where, bool armed);
+		~Scope();
+
+		Scope(const Scope&) = delete;
+		Scope& operator=(const Scope&) = delete;
+	};
+}
\ No newline at end of file
@@ -110,6 +110,14 @@ public:
         }
     }
 
+    // places the camera directly, used for scripted camera paths. The pitch is constrained like mouse movement
+    void setPose(glm::vec3 position, float yaw, float pitch) {
+        m_position = position;
+        m_yaw = yaw;
+        m_pitch = glm::clamp(pitch, -89.0f, 89.0f);
+        updateCameraVectors();
+    }
+
     // getters and setters
     float getZoom() { return m_zoom; }
     glm::vec3 getPosition() { return m_position; }
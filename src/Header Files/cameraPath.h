@@ -0,0 +1,44 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <string>
+#include <vector>
+
+// Scripted camera flight for benchmark replays. The path is a list of
+// keyframes read from a text file, one per line:
+//
+//   time  x y z  yaw pitch
+//
+// with the time in seconds and the angles in degrees, like Camera uses them.
+// Lines starting with # are comments. Between keyframes the pose follows a
+// Catmull-Rom spline through the keyframes, so the camera moves without
+// kinks; before the first and after the last keyframe it stays put
+
+class CameraPath {
+public:
+	struct Keyframe {
+		float time{};
+		glm::vec3 position{};
+		float yaw{};
+		float pitch{};
+	};
+
+private:
+	// state
+	std::vector<Keyframe> m_keyframes{};
+
+public:
+	// constructor
+	CameraPath() {  }
+
+	// reads the keyframes from the file, prints the reason and returns false if it can't be used
+	bool load(const std::string& path);
+
+	// the interpolated pose at the given time
+	Keyframe at(float time) const;
+
+	// getters
+	float getDuration() const;
+	int getKeyframeCount() const;
+};
\ No newline at end of file
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <surfaceEvaluator.h>
+#include <frameArena.h>
+#include <morph.h>
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+// Works out which faces of the cube grid can be seen. The cubes are wider than
+// the grid spacing, so neighbouring cubes overlap and most of their side faces
+// end up inside another cube. A face is dropped when
+//
+//   - it points away from the camera (the GPU would cull it after running the
+//     vertex shader anyway), or
+//   - the cube of one of the four edge neighbours (left, right, below, above
+//     in the grid) contains it. The diagonal neighbours are too far away to
+//     hold a whole face, so they aren't tested. The face may stick out of
+//     that cube by the cover tolerance in the plane of the face, a share of
+//     the cube size. Zero only drops faces that are covered exactly
+//
+// The visible faces are written as lists of sample indices, one list per face
+// of Shapes::cube, ready to be drawn with one instanced draw per face
+
+class FaceCuller {
+public:
+	// the faces in the order of Shapes::cube, six indices each in Shapes::cubeIndices
+	enum Face {
+		back,
+		front,
+		left,
+		right,
+		bottom,
+		top,
+	};
+	static inline constexpr int FACE_COUNT{ 6 };
+	static inline constexpr float DEFAULT_TOLERANCE{ 0.1f };
+
+	// where the lists of one update went and how many faces were dropped
+	struct FaceLists {
+		unsigned int offsets[FACE_COUNT]{};
+		unsigned int counts[FACE_COUNT]{};
+		unsigned long long backFacing{};
+		unsigned long long covered{};
+
+		unsigned long long visible() const;
+	};
+
+private:
+	// faces counted by one chunk of rows
+	struct ChunkCounts {
+		unsigned int faces[FACE_COUNT]{};
+		unsigned long long backFacing{};
+		unsigned long long covered{};
+	};
+
+	// totals of every update that showed a single surface
+	struct SurfaceTotals {
+		unsigned int updates{};
+		unsigned long long faces{};
+		unsigned long long backFacing{};
+		unsigned long long covered{};
+	};
+
+	// state
+	SurfaceEvaluator m_evaluator;
+	float m_tolerance{ DEFAULT_TOLERANCE };
+	std::vector<glm::vec3> m_points{};
+	std::vector<glm::vec3> m_targetPoints{};
+	std::vector<unsigned char> m_masks{};
+	std::vector<ChunkCounts> m_chunks{};
+	SurfaceTotals m_totals[Surfaces::COUNT]{};
+
+public:
+	// constructor, zero threads means one per hardware thread
+	FaceCuller(float tolerance = DEFAULT_TOLERANCE, unsigned int threadCount = 0)
+		: m_evaluator{ threadCount }
+		, m_tolerance{ tolerance }
+	{
+	}
+	// constructor, runs on a job system shared with other work
+	FaceCuller(JobSystem& jobs, float tolerance = DEFAULT_TOLERANCE)
+		: m_evaluator{ jobs }
+		, m_tolerance{ tolerance }
+	{
+	}
+
+	// evaluates the morph state over the grid and writes the sample index of every visible face
+	// into indices, face after face. indices needs room for maxIndices(grid) entries, the
+	// scratch lists of the update come from the arena
+	FaceLists update(const MorphState& state, const SurfaceGrid& grid, float t, glm::vec3 cameraPosition, unsigned int* indices,
+		FrameArena& arena);
+
+	// at most three faces of a cube point towards the camera
+	static int maxIndices(const SurfaceGrid& grid) { return 3 * grid.size(); }
+
+	// prints the share of triangles dropped per surface over every update so far
+	void printSummary();
+};
\ No newline at end of file
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+// Bump allocator for scratch memory that only lives for a frame or two:
+// culling lists, tile lists, sort keys. Allocating is an aligned pointer
+// increment and nothing is ever freed on its own, beginFrame() drops
+// everything allocated two frames earlier at once
+//
+// There is one region per frame in flight, so what was allocated in frame N
+// stays valid through frame N + 1 while frame N + 1 allocates from the other
+// region. The memory is reserved and touched up front, on Linux backed by
+// huge pages when the system has them, so allocating never faults in a page
+// or calls into the heap. An allocation that doesn't fit is taken from the
+// heap instead and counted, a sign the capacity is too small
+//
+// Not thread safe, allocate from the thread that calls beginFrame()
+
+class FrameArena {
+public:
+	static inline constexpr std::size_t ALIGNMENT{ 64 };
+	static inline constexpr int FRAMES_IN_FLIGHT{ 2 };
+
+	// how the regions are backed
+	enum class Backing {
+		none,
+		hugePages,				// explicit huge pages (MAP_HUGETLB)
+		transparentHugePages,	// ordinary pages the kernel was asked to merge into huge pages
+		heap,					// aligned operator new
+	};
+
+private:
+	struct Region {
+		unsigned char* memory{};
+		std::size_t used{};
+		// allocations that didn't fit, freed when the region is reset
+		std::vector<void*> overflow{};
+	};
+
+	// state
+	unsigned char* m_memory{};
+	std::size_t m_reserved{};
+	std::size_t m_capacity{};
+	Backing m_backing{ Backing::none };
+	Region m_regions[FRAMES_IN_FLIGHT]{};
+	int m_current{};
+
+	// statistics
+	std::size_t m_peak{};
+	unsigned long long m_overflows{};
+
+	void m_reset(Region& region);
+
+public:
+	// constructor
+	FrameArena() {  }
+	~FrameArena();
+
+	FrameArena(const FrameArena&) = delete;
+	FrameArena& operator=(const FrameArena&) = delete;
+
+	// reserves capacity bytes per frame in flight, prints the reason and returns false on failure
+	bool create(std::size_t capacity, bool hugePages = true);
+	void destroy();
+
+	// switches to the region of the oldest frame and drops everything allocated in it
+	void beginFrame();
+
+	// size bytes of the current frame's region, aligned to alignment (a power of two up to ALIGNMENT).
+	// The memory is not initialised
+	void* allocate(std::size_t size, std::size_t alignment = ALIGNMENT);
+	// count uninitialised objects, T must need no destructor since none is ever called
+	template <typename T>
+	T* allocate(std::size_t count) {
+		static_assert(std::is_trivially_destructible_v<T> && alignof(T) <= ALIGNMENT, "FrameArena never runs destructors");
+		return static_cast<T*>(allocate(count * sizeof(T), alignof(T)));
+	}
+
+	// prints the backing, the capacity and the most used in one frame
+	void printSummary();
+
+	// getters
+	std::size_t getCapacity();
+	std::size_t getPeak();
+	Backing getBacking();
+};
\ No newline at end of file
@@ -0,0 +1,41 @@
+#pragma once
+
+// Collects per-frame timings of the render loop and prints their averages
+// once every report interval, plus a summary over the whole run on exit
+
+class FrameStats {
+private:
+	struct Accumulator {
+		unsigned int frames{};
+		double frameTime{};
+		double frameTimeMax{};
+		double uploadTime{};
+		double uploadTimeMax{};
+		unsigned int uploadStalls{};
+	};
+
+	// state
+	double m_reportInterval{ 1.0 };
+	double m_intervalStart{ -1.0 };
+	Accumulator m_interval{};
+	Accumulator m_total{};
+
+	void m_print(const char* label, const Accumulator& accumulator);
+
+public:
+	// constructor
+	FrameStats(double reportInterval = 1.0)
+		: m_reportInterval{ reportInterval }
+	{
+	}
+
+	// records the duration of a whole frame
+	void addFrame(double frameTime);
+	// records the CPU time spent writing the per-frame instance stream
+	void addUpload(double uploadTime, bool stalled);
+
+	// prints the averages of the current interval if it has elapsed
+	void report(double currentTime);
+	// prints the averages over every recorded frame
+	void printSummary();
+};
\ No newline at end of file
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+// Everything the shaders need that changes at most once per frame, written
+// once per frame into a uniform buffer and bound at BINDING. Mirrors the
+// FrameData block of position.vert in the std140 layout, so the members
+// keep their order and every mat4 and vec4 stays 16 byte aligned
+//
+// Shader::compile binds the block of every program that declares it, so a
+// new program gets the frame data without any per-program uploads
+
+struct FrameUniforms {
+	static inline constexpr unsigned int BINDING{ 0 };
+	static inline constexpr const char* BLOCK_NAME{ "FrameData" };
+
+	glm::mat4 view{};
+	glm::mat4 projection{};
+	glm::mat4 viewProjection{};
+	// w is unused
+	glm::vec4 cameraPosition{};
+	float time{};
+	// blend and smoothed weight of the morph state, the surfaces as Surfaces::Surface values
+	float morphBlend{};
+	float morphWeight{};
+	int gridWidth{};
+	int morphFrom{};
+	int morphTo{};
+	// u and v between neighbouring samples, and the edge length of every cube, see SurfaceGrid
+	float gridStep{};
+	float scale{};
+};
+
+static_assert(sizeof(FrameUniforms) == 3 * 64 + 16 + 32, "FrameUniforms has to match the std140 layout of FrameData");
\ No newline at end of file
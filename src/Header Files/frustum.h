@@ -0,0 +1,44 @@
+#pragma once
+
+#include <surfaces.h>
+
+#include <glm/glm.hpp>
+
+// The six clip planes of a projection * view matrix, pointing inwards.
+// Extracted from the rows of the matrix (Gribb & Hartmann), so any box
+// that is entirely on the outside of one plane cannot be on screen
+
+struct Frustum {
+	glm::vec4 planes[6]{};
+
+	// constructor
+	Frustum(const glm::mat4& viewProjection) {
+		// glm matrices are column major, row i is (m[0][i], m[1][i], m[2][i], m[3][i])
+		glm::vec4 rows[4]{};
+		for (int i{ 0 }; i < 4; ++i) {
+			rows[i] = glm::vec4{ viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i] };
+		}
+		planes[0] = rows[3] + rows[0];	// left
+		planes[1] = rows[3] - rows[0];	// right
+		planes[2] = rows[3] + rows[1];	// bottom
+		planes[3] = rows[3] - rows[1];	// top
+		planes[4] = rows[3] + rows[2];	// near
+		planes[5] = rows[3] - rows[2];	// far
+	}
+
+	// returns false if the box is certainly outside, true if it might be visible
+	bool intersects(const Surfaces::Bounds& box) const {
+		for (const glm::vec4& plane : planes) {
+			// the corner furthest along the plane normal
+			glm::vec3 corner{
+				plane.x >= 0.0f ? box.max.x : box.min.x,
+				plane.y >= 0.0f ? box.max.y : box.min.y,
+				plane.z >= 0.0f ? box.max.z : box.min.z,
+			};
+			if (glm::dot(glm::vec3{ plane }, corner) + plane.w < 0.0f) {
+				return false;
+			}
+		}
+		return true;
+	}
+};
\ No newline at end of file
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <options.h>
+
 namespace GLOBALS {
 	// window settings
 	static inline constexpr unsigned int SCR_WIDTH{ 1600 };
@@ -8,6 +10,9 @@ namespace GLOBALS {
 	// constants
 	static inline constexpr float PI{ 3.1415926f };
 
+	// render settings, can be switched at runtime
+	static inline RenderMode renderMode{ RenderMode::instanceUpload };
+
 	// mouse stuff
 	static inline float lastX{ SCR_WIDTH / 2.0f };
 	static inline float lastY{ SCR_HEIGHT / 2.0f };
@@ -0,0 +1,44 @@
+#pragma once
+
+// Measures how long the GPU spends on one piece of every frame with
+// GL_TIME_ELAPSED queries, without the tracing build. A query is read back
+// QUERIES frames after it was issued, by then the stream buffer fences have
+// made sure the GPU finished it, so reading never stalls the frame
+//
+// Only one timer can be running at a time, GL can't nest elapsed queries
+
+class GpuTimer {
+private:
+	static inline constexpr int QUERIES{ 4 };
+
+	// state
+	unsigned int m_queries[QUERIES]{};
+	bool m_issued[QUERIES]{};
+	int m_next{};
+
+	// statistics
+	unsigned long long m_count{};
+	double m_total{};
+	double m_max{};
+
+	// adds the result of the query to the statistics
+	void m_collect(int query);
+
+public:
+	// constructor
+	GpuTimer() {  }
+
+	void create();
+	// reads the queries still outstanding, then deletes them
+	void destroy();
+
+	// starts timing the GL commands that follow
+	void begin();
+	void end();
+
+	// getters
+	unsigned long long getCount();
+	// seconds
+	double getAverage();
+	double getMax();
+};
\ No newline at end of file
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <surfaces.h>
+
+#include <vector>
+
+// Splits the instance grid into bands of whole rows, the chunks, so that no
+// buffer the renderer keeps per sample and no draw call covers more than a
+// chunk of instances. A single buffer for a 4096 wide grid would have to hold
+// 16M float3 instances, 200 MB per frame in flight, more than drivers place
+// reliably in one allocation
+//
+// Every chunk is a SurfaceGrid of its own starting at its first row, so the
+// face culler works on it unchanged. Its sample indices are relative to the
+// chunk, position.vert adds firstSample to get back to the whole grid. The
+// culler doesn't see across a chunk border and keeps the faces there, as it
+// does at the edge of the grid
+
+class GridChunks {
+public:
+	// samples per chunk, 48 MB of float3 instances
+	static inline constexpr int DEFAULT_MAX_SAMPLES{ 1 << 22 };
+
+	struct Chunk {
+		SurfaceGrid grid{};
+		int firstRow{};
+		int firstSample{};
+	};
+
+private:
+	std::vector<Chunk> m_chunks{};
+	int m_rowsPerChunk{};
+
+public:
+	// constructor, a chunk has a multiple of rowMultiple rows so chunk borders fall on tile borders.
+	// It has at most maxSamples samples unless that is less than rowMultiple rows
+	GridChunks(const SurfaceGrid& grid, int rowMultiple, int maxSamples = DEFAULT_MAX_SAMPLES);
+
+	// getters
+	const std::vector<Chunk>& getChunks();
+	int getCount();
+	// rows of every chunk but the last, which may have fewer
+	int getRowsPerChunk();
+	// samples of the largest chunk, what a buffer of one chunk has to hold
+	int getMaxSamples();
+};
\ No newline at end of file
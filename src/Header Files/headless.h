@@ -0,0 +1,40 @@
+#pragma once
+
+#include <chrono>
+
+// OpenGL context without a window or display, for benchmark machines that
+// have neither a GPU nor an X server. Uses a surfaceless EGL display (Mesa
+// llvmpipe works) and renders into a framebuffer object the size of the
+// window, with the same sample count as the window
+//
+// Only available where the build defines HAS_EGL, create() fails otherwise
+
+class HeadlessContext {
+private:
+	static inline constexpr int SAMPLES{ 4 };
+
+	// state
+	void* m_display{};
+	void* m_context{};
+	unsigned int m_framebuffer{};
+	unsigned int m_renderbuffers[2]{};
+	std::chrono::steady_clock::time_point m_start{};
+
+public:
+	// constructor
+	HeadlessContext() {  }
+
+	// creates the context, makes it current, loads the GL functions and binds
+	// a width * height framebuffer. Prints the reason and returns false on failure
+	bool create(int width, int height);
+	void destroy();
+
+	// waits until the GPU has finished the frame, stands in for swapping buffers
+	void finishFrame();
+
+	// seconds since create(), the headless glfwGetTime()
+	double getTime();
+
+	// getters
+	bool isActive();
+};
\ No newline at end of file
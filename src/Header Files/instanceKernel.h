@@ -0,0 +1,70 @@
+#pragma once
+
+#include <jobSystem.h>
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Builds the per-instance attribute of the instance upload modes: one entry
+// per grid sample with x and z the column and row around the grid centre,
+// gridWidth * gridWidth of them row after row. The float3 format also
+// carries the time as y, the compact formats leave it to the frame data
+// since it is the same for every instance
+//
+// The instances are written Simd::WIDTH at a time, the whole grid split
+// over a job system. When the output is aligned for it they go out with
+// streaming stores, which skip the caches: the data is only read again by
+// the GPU, so it would only evict what the rest of the frame is working on.
+// That makes the kernel bound by memory bandwidth, run surfaces-bench for
+// how close it gets and how the formats compare
+
+class InstanceKernel {
+public:
+	// instances written by one job, a multiple of Simd::WIDTH
+	static inline constexpr int GRAIN{ 16384 };
+
+	// layout of one instance, position.vert decodes it when compiled with shaderDefines()
+	enum class Format {
+		float3,		// x, time and z as floats, 12 bytes
+		short2,		// x and z as 16-bit integers, read with glVertexAttribIPointer, 4 bytes
+		half2,		// x and z as half floats, exact while the grid is at most 4096 wide, 4 bytes
+		packed,		// column in the low and row in the high 16 bits of an unsigned int, 4 bytes
+	};
+
+private:
+	JobSystem& m_jobs;
+	// the low 16 bits of every instance of a row in the 16-bit formats, the same in every row
+	std::vector<std::int32_t> m_columnCodes{};
+	int m_codeWidth{};
+	Format m_codeFormat{ Format::float3 };
+
+public:
+	// constructor
+	InstanceKernel(JobSystem& jobs)
+		: m_jobs{ jobs }
+	{
+	}
+
+	// fills output with the instances at the given time, in parallel. output needs room for
+	// gridWidth * gridWidth * instanceSize(format) bytes
+	void generate(int gridWidth, float time, Format format, void* output);
+	// the same for instances [first, first + count) of the grid, output needs room for count * instanceSize(format) bytes
+	void generate(int gridWidth, float time, Format format, void* output, int first, int count);
+	// the same on one thread and one instance at a time, the reference for tests and benchmarks
+	static void generateScalar(int gridWidth, float time, Format format, void* output);
+
+	// bytes per second every thread of the job system together writes to memory with streaming stores,
+	// the best of a few passes over a buffer of the given size. The upper bound for generate() on this machine
+	double measureWriteBandwidth(std::size_t size);
+
+	// bytes of one instance
+	static std::size_t instanceSize(Format format);
+	// the widest grid the format can address exactly
+	static int maxGridWidth(Format format);
+	static const char* formatName(Format format);
+	// the defines position.vert needs to read the format
+	static const char* shaderDefines(Format format);
+};
\ No newline at end of file
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <tripleBuffer.h>
+#include <jobSystem.h>
+#include <instanceKernel.h>
+
+#include <glm/glm.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+// Builds the per-instance data of the instance upload mode on its own
+// thread, so filling the next frame overlaps with the render thread
+// uploading and drawing the current one. The grid is filled by the
+// InstanceKernel on a JobSystem, with the producer thread working along
+//
+// The render thread asks for the animation time of the frame after the one
+// it is drawing with request(), and takes the newest finished frame with
+// acquire(). The frames are handed over through a TripleBuffer, so the
+// render thread never waits: if the requested frame isn't finished yet it
+// draws the last one again and counts it as repeated. A replay has to draw
+// exactly its own frames, so there acquire(time) waits for the frame of
+// that time instead. The producer only sleeps while there is no request it
+// hasn't built yet
+//
+// The three frames are whole grids of instances, so they are only allocated
+// by create(), once the upload mode is actually used
+
+class InstanceProducer {
+public:
+	struct Frame {
+		// gridWidth * gridWidth instances in the format of the producer
+		std::vector<unsigned char> instances{};
+		float time{};
+		std::chrono::steady_clock::time_point published{};
+	};
+
+private:
+	// state
+	int m_gridWidth{};
+	InstanceKernel::Format m_format{};
+	InstanceKernel m_kernel;
+	TripleBuffer<Frame> m_frames;
+	std::thread m_thread{};
+	std::atomic<float> m_requestedTime{};
+	// incremented by every request and by stop, the producer sleeps on it
+	std::atomic<unsigned int> m_requests{};
+	std::atomic<bool> m_stop{};
+	// incremented by every published frame, acquire(time) sleeps on it
+	std::atomic<unsigned int> m_published{};
+
+	// producer statistics, only written by the producer thread and read after stop
+	unsigned long long m_produced{};
+	double m_produceTime{};
+	double m_produceTimeMax{};
+
+	// consumer statistics
+	unsigned long long m_acquired{};
+	unsigned long long m_repeated{};
+	unsigned long long m_waited{};
+	double m_latency{};
+	double m_latencyMax{};
+
+	void m_run();
+	// builds the instances of the given time into frame
+	void m_fill(Frame& frame, float time);
+	// counts the frame as drawn and returns it
+	const Frame& m_take(const Frame& frame);
+
+public:
+	// constructor, the instance grid is gridWidth * gridWidth. Allocates nothing yet
+	InstanceProducer(int gridWidth, InstanceKernel::Format format, JobSystem& jobs);
+	~InstanceProducer();
+
+	InstanceProducer(const InstanceProducer&) = delete;
+	InstanceProducer& operator=(const InstanceProducer&) = delete;
+
+	// allocates the three frames, returns false with an error message if they don't fit in memory.
+	// Does nothing once they are allocated
+	bool create();
+	// builds the frame of the given time on the calling thread, so there is always one to acquire, and starts the producer.
+	// create() has to have succeeded
+	void start(float time);
+	// stops and joins the producer
+	void stop();
+
+	// asks the producer to build the frame of the given time next
+	void request(float time);
+	// the newest finished frame, valid until the next call. Never waits
+	const Frame& acquire();
+	// the frame of exactly the given time, valid until the next call. Requests it if the producer isn't
+	// building it already and waits until it is finished
+	const Frame& acquire(float time);
+
+	// prints the throughput of the producer and the latency of the frames the render thread drew
+	void printSummary();
+
+	// getters
+	// true between start and stop
+	bool isRunning();
+};
\ No newline at end of file
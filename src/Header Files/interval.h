@@ -0,0 +1,151 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// Closed interval [lo, hi] of floats. Every operation returns an interval
+// that contains the result for every choice of arguments in the argument
+// intervals, rounded outwards by one float so rounding can never make it
+// too small. Evaluating a formula on intervals therefore gives guaranteed
+// bounds over a whole box of inputs, without sampling it
+//
+// The bounds are tight for every operation on its own, but a variable that
+// appears more than once in a formula is treated as independent values, so
+// u * u over [-1, 1] gives [-1, 1]. Use square() for those
+
+struct Interval {
+	float lo{};
+	float hi{};
+
+	// constructors
+	Interval() {  }
+	Interval(float value)
+		: lo{ value }
+		, hi{ value }
+	{
+	}
+	Interval(float lo, float hi)
+		: lo{ lo }
+		, hi{ hi }
+	{
+	}
+
+	float width() const { return hi - lo; }
+	float middle() const { return 0.5f * (lo + hi); }
+	bool contains(float value) const { return lo <= value && value <= hi; }
+};
+
+namespace IntervalDetail {
+	inline constexpr float INF{ std::numeric_limits<float>::infinity() };
+	// The bounds of sin and cos have to hold for the GPU too, whose sin and cos GLSL leaves without a precision.
+	// Over [-PI, PI] std::sin/std::cos and the hardware versions of desktop GPUs are within TRIG_ERROR, in absolute
+	// terms. Larger angles (the surfaces pass PI * (16 u + 8 v + 3 t), which grows with the time) are reduced to
+	// that range in float first, which loses a few roundings of the angle, so the error grows with its magnitude
+	inline constexpr float TRIG_ERROR{ 1e-6f };
+	inline constexpr float TRIG_ARGUMENT_ERROR{ 4.0f * std::numeric_limits<float>::epsilon() };
+
+	// rounds outwards by one float
+	inline Interval widen(float lo, float hi) {
+		return Interval{ std::nextafter(lo, -INF), std::nextafter(hi, INF) };
+	}
+
+	// largest error of a sine or cosine of any angle in x
+	inline float trigError(Interval x) {
+		return TRIG_ERROR + TRIG_ARGUMENT_ERROR * std::max(std::abs(x.lo), std::abs(x.hi));
+	}
+}
+
+inline Interval operator+(Interval a, Interval b) { return IntervalDetail::widen(a.lo + b.lo, a.hi + b.hi); }
+inline Interval operator-(Interval a, Interval b) { return IntervalDetail::widen(a.lo - b.hi, a.hi - b.lo); }
+inline Interval operator-(Interval a) { return Interval{ -a.hi, -a.lo }; }
+
+inline Interval operator*(Interval a, Interval b) {
+	float p0{ a.lo * b.lo };
+	float p1{ a.lo * b.hi };
+	float p2{ a.hi * b.lo };
+	float p3{ a.hi * b.hi };
+	return IntervalDetail::widen(std::min({ p0, p1, p2, p3 }), std::max({ p0, p1, p2, p3 }));
+}
+
+inline Interval operator/(Interval a, Interval b) {
+	// a divisor that can be zero can make the quotient anything
+	if (b.contains(0.0f)) {
+		return Interval{ -IntervalDetail::INF, IntervalDetail::INF };
+	}
+	float q0{ a.lo / b.lo };
+	float q1{ a.lo / b.hi };
+	float q2{ a.hi / b.lo };
+	float q3{ a.hi / b.hi };
+	return IntervalDetail::widen(std::min({ q0, q1, q2, q3 }), std::max({ q0, q1, q2, q3 }));
+}
+
+// x * x, but without treating both factors as independent
+inline Interval square(Interval x) {
+	float a{ x.lo * x.lo };
+	float b{ x.hi * x.hi };
+	if (x.contains(0.0f)) {
+		return Interval{ 0.0f, std::nextafter(std::max(a, b), IntervalDetail::INF) };
+	}
+	return IntervalDetail::widen(std::min(a, b), std::max(a, b));
+}
+
+inline Interval sqrt(Interval x) {
+	// negative parts are outside the domain and ignored, like rounding noise around zero
+	float lo{ std::sqrt(std::max(x.lo, 0.0f)) };
+	float hi{ std::sqrt(std::max(x.hi, 0.0f)) };
+	return Interval{ std::max(0.0f, std::nextafter(lo, 0.0f)), std::nextafter(hi, IntervalDetail::INF) };
+}
+
+// sine over the interval: the values at the ends, widened to +-1 if a peak or trough lies inside
+inline Interval sin(Interval x) {
+	constexpr float TWO_PI{ 6.28318530718f };
+	if (!(x.width() < TWO_PI)) {
+		return Interval{ -1.0f, 1.0f };
+	}
+	float a{ std::sin(x.lo) };
+	float b{ std::sin(x.hi) };
+	float error{ IntervalDetail::trigError(x) };
+	float lo{ std::min(a, b) - error };
+	float hi{ std::max(a, b) + error };
+
+	// the peaks are at PI / 2 + 2 k PI and the troughs at -PI / 2 + 2 k PI. The rounding of the
+	// quotients below can only move the test by a hair, so a peak at the very end counts as inside
+	double peak{ std::ceil((static_cast<double>(x.lo) - 1.5707963267948966) / 6.283185307179586) * 6.283185307179586 + 1.5707963267948966 };
+	if (peak <= static_cast<double>(x.hi) + 1e-6) {
+		hi = 1.0f;
+	}
+	double trough{ std::ceil((static_cast<double>(x.lo) + 1.5707963267948966) / 6.283185307179586) * 6.283185307179586 - 1.5707963267948966 };
+	if (trough <= static_cast<double>(x.hi) + 1e-6) {
+		lo = -1.0f;
+	}
+	return Interval{ std::max(lo, -1.0f), std::min(hi, 1.0f) };
+}
+
+inline Interval cos(Interval x) {
+	// cos(x) = sin(x + PI / 2), shifted in double so the shift adds no rounding
+	constexpr double HALF_PI{ 1.5707963267948966 };
+	Interval shifted{ std::nextafter(static_cast<float>(x.lo + HALF_PI), -IntervalDetail::INF),
+		std::nextafter(static_cast<float>(x.hi + HALF_PI), IntervalDetail::INF) };
+	return sin(shifted);
+}
+
+// smoothstep(0, 1, x), increasing, so the ends map to the ends
+inline Interval smoothstep(Interval x) {
+	auto step{ [](float x) {
+		double t{ std::clamp(x, 0.0f, 1.0f) };
+		return static_cast<float>(t * t * (3.0 - 2.0 * t));
+	} };
+	return IntervalDetail::widen(step(x.lo), step(x.hi));
+}
+
+// a * (1 - weight) + b * weight for a weight in [0, 1]. The blend grows with a and b and is
+// linear in the weight, so its bounds are at the corners. Computed in double to keep the rounding
+// within the final one float widening
+inline Interval mix(Interval a, Interval b, Interval weight) {
+	double w0{ std::clamp(weight.lo, 0.0f, 1.0f) };
+	double w1{ std::clamp(weight.hi, 0.0f, 1.0f) };
+	double lo{ std::min(a.lo * (1.0 - w0) + b.lo * w0, a.lo * (1.0 - w1) + b.lo * w1) };
+	double hi{ std::max(a.hi * (1.0 - w0) + b.hi * w0, a.hi * (1.0 - w1) + b.hi * w1) };
+	return IntervalDetail::widen(static_cast<float>(lo), static_cast<float>(hi));
+}
\ No newline at end of file
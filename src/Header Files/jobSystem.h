@@ -0,0 +1,227 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Work-stealing scheduler for the CPU side of a frame: evaluation, culling,
+// instance generation. Every thread has a Chase-Lev deque: it pushes and
+// pops jobs at the bottom of its own deque without any locking, and threads
+// that run out of work steal from the top of someone else's. Loops are split
+// in halves lazily, a thread keeps working on one half and leaves the other
+// to be stolen, so an idle thread always finds a large piece of work
+//
+// Worker threads are started up front. Any other thread that submits work
+// gets a deque on its first call and works along while it waits, so the
+// render thread and the instance producer help with their own loops. Idle
+// workers sleep until something is pushed
+//
+// Jobs come from a fixed ring per thread and are never allocated. If a
+// thread has JOB_CAPACITY jobs that haven't run yet, it runs the next one
+// itself instead of queueing it. Run jobsystem-stress after changing the
+// scheduler, it checks loops, dependencies and many submitting threads
+
+class JobSystem {
+public:
+	static inline constexpr int JOB_CAPACITY{ 1024 };
+	// threads that aren't workers but submit work, beyond that they run their loops alone
+	static inline constexpr int MAX_EXTERNAL_THREADS{ 8 };
+	// arguments of a job, a task given to run() has to fit
+	static inline constexpr std::size_t JOB_STORAGE{ 48 };
+
+	struct Job;
+
+	// Counts the unfinished jobs of a group. wait() returns once it reaches
+	// zero, and jobs can be made to start only after it does. A job that is
+	// made to depend on a counter starts the first time the counter is zero
+	// at or after that point, so all jobs of the group should be added first
+	class Counter {
+	private:
+		friend class JobSystem;
+		std::atomic<int> m_pending{};
+		std::mutex m_mutex{};
+		// jobs waiting for the counter to reach zero, linked through Job::next
+		Job* m_dependents{};
+
+	public:
+		Counter() {  }
+		Counter(const Counter&) = delete;
+		Counter& operator=(const Counter&) = delete;
+
+		bool isDone() const { return m_pending.load(std::memory_order_acquire) == 0; }
+	};
+
+	struct Job {
+		void (*function)(JobSystem& system, Job& job){};
+		Counter* counter{};
+		Job* next{};
+		// false from allocation until the job has run, the slot is reused after that
+		std::atomic<bool> finished{ true };
+		alignas(16) unsigned char storage[JOB_STORAGE]{};
+	};
+
+private:
+	static inline constexpr int MAX_THREADS{ 256 };
+
+	// bounded Chase-Lev deque (Le, Pop, Cohen, Zappa Nardelli: Correct and
+	// Efficient Work-Stealing for Weak Memory Models, 2013). The owner pushes
+	// and pops at the bottom, thieves take from the top
+	class Deque {
+	private:
+		alignas(64) std::atomic<std::int64_t> m_top{};
+		alignas(64) std::atomic<std::int64_t> m_bottom{};
+		std::atomic<Job*> m_slots[JOB_CAPACITY]{};
+
+	public:
+		// owner only, false if the deque is full
+		bool push(Job* job);
+		// owner only
+		Job* pop();
+		// any thread, nullptr if empty or another thread won the race
+		Job* steal();
+	};
+
+	struct Thread {
+		Deque deque{};
+		std::unique_ptr<Job[]> jobs{ new Job[JOB_CAPACITY] };
+		unsigned int nextJob{};
+		std::thread::id id{};
+		// state of the victim choice when stealing
+		unsigned int random{};
+	};
+
+	// a 2D loop that was split into jobs, lives on the stack of the thread waiting for it
+	struct Loop {
+		const void* task{};
+		void (*invoke)(const void* task, int rowBegin, int rowEnd, int columnBegin, int columnEnd){};
+		int rows{};
+		int columns{};
+		int rowGrain{};
+		int columnGrain{};
+		Counter counter{};
+	};
+
+	// a block of a Loop in grain units
+	struct Range {
+		Loop* loop{};
+		int rowBegin{};
+		int rowEnd{};
+		int columnBegin{};
+		int columnEnd{};
+	};
+
+	// state
+	std::uint64_t m_serial{};
+	unsigned int m_workerCount{};
+	std::vector<std::thread> m_workers{};
+	// the deques of the workers followed by the external threads, filled in as threads arrive
+	std::atomic<Thread*> m_threads[MAX_THREADS]{};
+	std::atomic<int> m_threadCount{};
+	std::mutex m_registerMutex{};
+	// bumped by every push, idle workers sleep on it
+	std::atomic<unsigned int> m_epoch{};
+	std::atomic<int> m_sleeping{};
+	std::atomic<bool> m_stop{};
+
+	void m_workerLoop(int index);
+	// the calling thread's entry, registered on first use. nullptr if there is no room left
+	Thread* m_currentThread();
+	// takes a job from the thread's own deque or steals one
+	Job* m_find(Thread& thread);
+	// a free job slot of the calling thread, nullptr if every slot is still waiting to run
+	Job* m_allocate(Thread* thread);
+	// queues the job on the calling thread or runs it right away if there is no room
+	void m_push(Thread* thread, Job* job);
+	void m_execute(Job* job);
+	// queues the job once dependency has reached zero
+	void m_submit(Job* job, Counter* dependency);
+	void m_finish(Counter& counter);
+	// splits the range until it is one grain in both directions, leaving the other halves to be stolen
+	static void m_runRange(JobSystem& system, Job& job);
+	void m_runRange(Range range);
+
+public:
+	// constructor, zero threads means one per hardware thread. The thread
+	// that submits work counts as one, so one thread starts no workers
+	JobSystem(unsigned int threadCount = 0);
+	~JobSystem();
+
+	JobSystem(const JobSystem&) = delete;
+	JobSystem& operator=(const JobSystem&) = delete;
+
+	// runs task() on some thread. counter counts it until it has finished, and if dependency
+	// is given the task only starts after it has reached zero. Either may be nullptr
+	template <typename Task>
+	void run(Task task, Counter* counter, Counter* dependency = nullptr);
+	// returns once the counter is zero, running other jobs in the meantime
+	void wait(Counter& counter);
+
+	// calls task(begin, end) for consecutive ranges of at most grain items covering [0, count), every range starts
+	// at a multiple of grain. Returns once all of them are done, the calling thread works along
+	template <typename Task>
+	void parallelFor(int count, int grain, const Task& task);
+	// calls task(rowBegin, rowEnd, columnBegin, columnEnd) for blocks of at most rowGrain * columnGrain
+	// items covering rows * columns, aligned to the grains. Returns once all of them are done
+	template <typename Task>
+	void parallelFor2D(int rows, int columns, int rowGrain, int columnGrain, const Task& task);
+
+	// getters
+	// the workers and the thread that submits work
+	unsigned int getThreadCount();
+};
+
+template <typename Task>
+void JobSystem::run(Task task, Counter* counter, Counter* dependency) {
+	static_assert(sizeof(Task) <= JOB_STORAGE && alignof(Task) <= 16, "the task doesn't fit into a job, capture less or by reference");
+
+	Job* job{ m_allocate(m_currentThread()) };
+	if (job == nullptr) {
+		// out of slots, run it here. A dependency still has to be waited for
+		if (dependency != nullptr) {
+			wait(*dependency);
+		}
+		task();
+		return;
+	}
+	new (job->storage) Task{ std::move(task) };
+	job->function = [](JobSystem&, Job& self) {
+		Task* stored{ std::launder(reinterpret_cast<Task*>(self.storage)) };
+		(*stored)();
+		stored->~Task();
+	};
+	job->counter = counter;
+	if (counter != nullptr) {
+		counter->m_pending.fetch_add(1, std::memory_order_relaxed);
+	}
+	m_submit(job, dependency);
+}
+
+template <typename Task>
+void JobSystem::parallelFor(int count, int grain, const Task& task) {
+	parallelFor2D(count, 1, grain, 1, [&task](int rowBegin, int rowEnd, int, int) { task(rowBegin, rowEnd); });
+}
+
+template <typename Task>
+void JobSystem::parallelFor2D(int rows, int columns, int rowGrain, int columnGrain, const Task& task) {
+	if (rows <= 0 || columns <= 0) {
+		return;
+	}
+	Loop loop{};
+	loop.task = &task;
+	loop.invoke = [](const void* task, int rowBegin, int rowEnd, int columnBegin, int columnEnd) {
+		(*static_cast<const Task*>(task))(rowBegin, rowEnd, columnBegin, columnEnd);
+	};
+	loop.rows = rows;
+	loop.columns = columns;
+	loop.rowGrain = std::max(1, rowGrain);
+	loop.columnGrain = std::max(1, columnGrain);
+
+	m_runRange(Range{ &loop, 0, (rows + loop.rowGrain - 1) / loop.rowGrain, 0, (columns + loop.columnGrain - 1) / loop.columnGrain });
+	wait(loop.counter);
+}
\ No newline at end of file
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <surfaces.h>
+#include <morph.h>
+#include <frustum.h>
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+// Continuous distance-dependent level of detail for the surface grid, after
+// CDLOD. A quadtree over the grid's u/v domain whose leaves are patches of
+// PATCH_QUADS x PATCH_QUADS grid steps, every level above doubling the
+// patch and the step between its vertices. Every patch is drawn with the
+// same PATCH_QUADS x PATCH_QUADS mesh, so the deepest level draws the grid
+// at full density and every level above a quarter of the vertices
+//
+// A level is fine enough once its vertex step, seen from the camera,
+// projects to at most the pixel error. That makes every level good from a
+// distance that doubles with the level: a node is drawn whole when the
+// closest point of its box is that far away and split into its four
+// children otherwise, starting at the root and one level at a time so the
+// node budget goes to the nearest parts of the surface first. Nodes outside
+// the view frustum are dropped
+//
+// The vertices of a node morph into those of its parent over the last part
+// of the node's distance range (see position.vert), so a node looks like its
+// parent by the time it is replaced by it and the levels don't pop. The edge
+// between a node and a coarser neighbour is always fully morphed, which also
+// keeps the mesh free of cracks
+//
+// Both that and the pixel error only hold while the node budget lasts. Once
+// it runs out the remaining nodes are drawn unsplit, next to split
+// neighbours that may be more than a level finer. The selection never has
+// more nodes than the grid has leaves, so the budget is capped at that and
+// only grids larger than DEFAULT_MAX_NODES leaves can run out at all.
+// printSummary warns when it happened
+
+class LodQuadtree {
+public:
+	// quads along the side of every patch, a power of two
+	static inline constexpr int PATCH_QUADS{ 32 };
+	// enough for a 4096 grid at full density, 24 bytes a node
+	static inline constexpr int DEFAULT_MAX_NODES{ 32768 };
+	// the largest on-screen size of a vertex step in pixels
+	static inline constexpr float DEFAULT_PIXEL_ERROR{ 1.0f };
+	// share of a level's distance range after which its vertices start to morph
+	static inline constexpr float MORPH_START{ 0.7f };
+
+	// a selected node, drawn as one patch. The layout is read by the lod VAO
+	struct Node {
+		// u and v of the first vertex, and between neighbouring vertices. The grid is square, the step is the same for both
+		float uStart{};
+		float vStart{};
+		float step{};
+		// camera distances between which the vertices morph into the parent's
+		float morphStart{};
+		float morphEnd{};
+		int level{};
+	};
+
+private:
+	// a node waiting to be drawn or split, in grid steps from the first sample
+	struct Candidate {
+		int level{};
+		int column{};
+		int row{};
+		float distance{};
+	};
+
+	// state
+	SurfaceGrid m_grid{};
+	int m_maxNodes{};
+	float m_pixelError{};
+	int m_rootLevel{};
+	// the distance from which every level is fine enough, one more than there are levels
+	std::vector<float> m_ranges{};
+	std::vector<Node> m_nodes{};
+	std::vector<Candidate> m_candidates{};
+	std::vector<Candidate> m_children{};
+	// grid samples the nodes of the last selection put a vertex on, see m_ownedSamples
+	long long m_samples{};
+
+	// statistics
+	unsigned int m_frames{};
+	unsigned long long m_selectedNodes{};
+	// grid samples the selected nodes put a vertex on, see m_ownedSamples
+	unsigned long long m_selectedSamples{};
+	unsigned int m_maxSelected{};
+	unsigned int m_budgetFrames{};
+	std::vector<unsigned long long> m_levelNodes{};
+
+	// adds the child of the given node at column, row if it is on the grid and in the frustum
+	void m_addChild(const MorphState& state, float t, const glm::vec3& cameraPosition, const Frustum& frustum, int level, int column, int row);
+	// the node of the candidate with its morph range
+	Node m_makeNode(const Candidate& candidate);
+	// the grid samples of the candidate's vertices, without the vertices the shader clamps onto the last sample and without
+	// the far edges, which belong to the next node. At full density the nodes have every sample of the grid exactly once
+	long long m_ownedSamples(const Candidate& candidate) const;
+
+public:
+	// constructor, at most maxNodes patches are selected per frame, fewer if the grid has fewer leaves
+	LodQuadtree(const SurfaceGrid& grid, int maxNodes = DEFAULT_MAX_NODES, float pixelError = DEFAULT_PIXEL_ERROR);
+
+	// the patches to draw this frame. pixelsPerUnit is how many pixels one unit spans at a distance of one,
+	// half the viewport height times projection[1][1]
+	const std::vector<Node>& select(const MorphState& state, float t, const glm::vec3& cameraPosition, const glm::mat4& viewProjection,
+		float pixelsPerUnit);
+
+	// the u and v of the last sample of the grid, the patches at the far edges are clamped to it
+	glm::vec2 getEnd();
+	// vertices of one patch
+	static int patchVertices() { return (PATCH_QUADS + 1) * (PATCH_QUADS + 1); }
+
+	// prints the patches and vertices drawn and the share of the grid's samples they hit, and warns if the budget ran out
+	void printSummary();
+
+	// getters
+	int getMaxNodes();
+	// grid samples the last selection puts a vertex on, at most the size of the grid
+	long long getSelectedSamples();
+	int getLevelCount();
+};
\ No newline at end of file
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <surfaces.h>
+
+// The 20 second morph cycle of the renderer: every surface is shown for three
+// seconds and then blends into the next one over one second
+//
+//   0 - 3   wave           3 - 4   wave -> multiWave
+//   4 - 7   multiWave      7 - 8   multiWave -> ripple
+//   8 - 11  ripple        11 - 12  ripple -> sphere
+//  12 - 15  sphere        15 - 16  sphere -> torus
+//  16 - 19  torus         19 - 20  torus -> wave
+
+struct MorphState {
+	Surfaces::Surface from{ Surfaces::Surface::wave };
+	Surfaces::Surface to{ Surfaces::Surface::wave };
+	// progress of the transition in [0, 1), before smoothing
+	float blend{};
+
+	bool isTransition() const { return from != to; }
+	// the weight of the target surface, smoothstep(0, 1, blend) like mixMat4 in position.vert
+	float weight() const { return blend * blend * (3.0f - 2.0f * blend); }
+};
+
+namespace Morph {
+	static inline constexpr float CYCLE{ 20.0f };
+	static inline constexpr float PHASE{ 4.0f };
+
+	// returns which surfaces are visible at the given time
+	MorphState at(float time);
+	// evaluates the (possibly blended) surface point for the morph state
+	glm::vec3 evaluate(const MorphState& state, float u, float v, float t);
+	// bounds of the (possibly blended) surface over the box of u, v and t, see Surfaces::bounds
+	Surfaces::Bounds bounds(const MorphState& state, Interval u, Interval v, Interval t);
+}
\ No newline at end of file
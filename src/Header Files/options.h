@@ -0,0 +1,64 @@
+#pragma once
+
+#include <instanceKernel.h>
+#include <gridChunks.h>
+#include <lodQuadtree.h>
+#include <tessellationPatches.h>
+
+#include <string>
+
+// How the surface samples are drawn and how their grid coordinates reach the vertex shader
+enum class RenderMode {
+	instanceUpload,	// one cube per sample, the CPU fills and uploads one instance attribute per cube every frame
+	instanceStream,	// like instanceUpload, but the instances are written straight into the mapped buffer with streaming stores
+	procedural,		// one cube per sample, the vertex shader derives them from gl_InstanceID
+	visibleFaces,	// only the cube faces the CPU found visible, one instanced draw per face
+	tiles,			// one cube per sample of the tiles inside the view frustum
+	mesh,			// one shared vertex per sample connected into a triangle mesh, derived from gl_VertexID
+	lod,			// mesh patches whose vertex density falls with the camera distance, see lodQuadtree.h
+	tessellation,	// coarse patches refined by the tessellation stages, see tessellationPatches.h. Needs ARB_tessellation_shader
+};
+
+// returns the mode that follows the given one, used to cycle through the modes at runtime
+RenderMode nextRenderMode(RenderMode mode);
+
+// Settings that can be given on the command line
+struct Options {
+	static inline constexpr int DEFAULT_HEADLESS_FRAMES{ 300 };
+	static inline constexpr float DEFAULT_TIMESTEP{ 1.0f / 60.0f };
+	static inline constexpr const char* DEFAULT_SHADER_CACHE{ "shaderCache" };
+	static inline constexpr int DEFAULT_GRID_WIDTH{ 1414 };
+
+	RenderMode renderMode{ RenderMode::instanceUpload };
+	// layout of the instance attribute of the upload and stream modes, see instanceKernel.h
+	InstanceKernel::Format instanceFormat{ InstanceKernel::Format::float3 };
+	// samples per row and column of the grid, u and v span [-1, 1] at any width
+	int gridWidth{ DEFAULT_GRID_WIDTH };
+	// most samples a buffer or draw of the grid covers, see gridChunks.h
+	int chunkSamples{ GridChunks::DEFAULT_MAX_SAMPLES };
+	// largest on-screen size of a vertex step of the lod mode in pixels
+	float lodPixelError{ LodQuadtree::DEFAULT_PIXEL_ERROR };
+	// largest on-screen distance of the tessellation mode's surface from the true one in pixels
+	float tessellationPixelError{ TessellationPatches::DEFAULT_PIXEL_ERROR };
+	// render offscreen without a window, see headless.h
+	bool headless{};
+	// stop after this many frames, 0 runs until the window is closed
+	int frames{};
+	// camera path file for a benchmark replay, see cameraPath.h. Empty for interactive use
+	std::string replayPath{};
+	// seconds of animation per frame during a replay, independent of how long the frames take
+	float timestep{ DEFAULT_TIMESTEP };
+	// Chrome trace JSON written on exit, see trace.h. Empty for no trace
+	std::string tracePath{};
+	// directory of the program binary cache, see programBinaryCache.h. Empty compiles every launch
+	std::string shaderCachePath{ DEFAULT_SHADER_CACHE };
+	// directory the shaders are loaded from and reloaded from on change, see rendererPrograms.h.
+	// Empty uses the shaders compiled into the binary
+	std::string shaderDirectory{};
+};
+
+// parses the command line into options, prints the usage and returns false on invalid arguments
+bool parseOptions(int argc, char* argv[], Options& options);
+
+// returns a printable name for the given render mode
+const char* renderModeName(RenderMode mode);
\ No newline at end of file
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <shaderSources.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+// On-disk cache of linked programs, so a program that was built once is
+// loaded with glProgramBinary on later launches instead of being compiled
+// from source again
+//
+// Every program is stored under a hash of its sources, its defines and the
+// vendor, renderer and version strings of the driver, so a changed shader or
+// a driver update never picks up a stale binary. A binary the driver rejects
+// anyway is treated like a miss: Shader compiles from source and replaces it
+
+class ProgramBinaryCache {
+private:
+	// state
+	std::filesystem::path m_directory{};
+	std::string m_driver{};
+	bool m_enabled{};
+
+	// statistics
+	unsigned int m_hits{};
+	unsigned int m_misses{};
+	unsigned int m_rejected{};
+
+	std::filesystem::path m_file(std::uint64_t key) const;
+
+public:
+	// constructor
+	ProgramBinaryCache() {  }
+
+	// uses the directory for the cache, needs a current GL context. Prints the reason and
+	// returns false if the driver can't return program binaries, the cache then does nothing
+	bool open(const std::string& directory);
+
+	// the key of a program with the given sources and defines, any of them may be nullptr
+	std::uint64_t key(const ShaderSources& sources, const char* defines) const;
+
+	// loads the binary stored under key into the program, returns false if it has to be compiled from source
+	bool load(unsigned int program, std::uint64_t key);
+	// stores the binary of a linked program that was created with GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+	void store(unsigned int program, std::uint64_t key);
+
+	// prints how many programs came from the cache
+	void printSummary();
+
+	// getters
+	bool isEnabled();
+};
\ No newline at end of file
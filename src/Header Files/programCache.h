@@ -0,0 +1,49 @@
+#pragma once
+
+#include <shader.h>
+#include <shaderCompiler.h>
+#include <morph.h>
+
+#include <future>
+#include <string>
+#include <vector>
+
+// Holds one program per morph state. Every program is the same source
+// specialised through #defines for a single surface or a (from, to) pair,
+// so the vertex stage evaluates its surface once without any branching
+
+class ProgramCache {
+private:
+	// state
+	ShaderSources m_sources{};
+	std::string m_defines{};
+	ProgramBinaryCache* m_binaryCache{};
+	Shader m_programs[Surfaces::COUNT][Surfaces::COUNT]{};
+
+	void m_compile(Surfaces::Surface from, Surfaces::Surface to);
+
+public:
+	// constructor
+	ProgramCache() {  }
+
+	// compiles the programs for every state of the morph cycle up front,
+	// defines are added to every program. The sources and the binary cache must outlive the cache
+	void compile(const ShaderSources& sources, const std::string& defines = "", ProgramBinaryCache* binaryCache = nullptr);
+
+	// like compile, but only submits the programs to the compiler, they are ready once it has finished them.
+	// Returns one future per submitted program, resolved with whether it linked
+	std::vector<std::future<bool>> submit(ShaderCompiler& compiler, const ShaderSources& sources, const std::string& defines = "",
+		ProgramBinaryCache* binaryCache = nullptr);
+
+	// deletes every program, none may still be compiling
+	void destroy();
+
+	// returns the program for the given morph state
+	Shader& get(const MorphState& state);
+
+	// uniform uploads skipped by all programs because the value was already set
+	unsigned long long getSkippedUploads();
+
+	// returns the #define block that specialises a program for the given surfaces
+	static std::string surfaceDefines(Surfaces::Surface from, Surfaces::Surface to);
+};
\ No newline at end of file
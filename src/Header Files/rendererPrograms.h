@@ -0,0 +1,98 @@
+#pragma once
+
+#include <programCache.h>
+#include <shaderCompiler.h>
+#include <shaderWatcher.h>
+
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+// The program caches the renderer draws with, one for the cubes, one for
+// the cubes drawn from a sample list, one for the mesh, one for the level of
+// detail patches and one for the tessellated patches, all built from the
+// same vertex and fragment source. The tessellated programs compile the
+// vertex source as their tessellation stages too, they are only built when
+// the context has ARB_tessellation_shader
+//
+// The sources are either the ones compiled into the binary or the files
+// position.vert and position.frag in a shader directory. In the second case
+// the files are watched, and an edit builds a complete new set of programs
+// through the ShaderCompiler while the old set keeps drawing. update()
+// swaps the sets once every new program has linked, which only happens
+// between frames, so a frame never mixes old and new programs. If any of
+// them fails, the error is printed and the old set stays in use
+
+class RendererPrograms {
+private:
+	struct ProgramSet {
+		// the caches point into these, so they live as long as the set
+		std::string vertexSource{};
+		std::string fragmentSource{};
+		ProgramCache cubes{};
+		ProgramCache sampleList{};
+		ProgramCache mesh{};
+		ProgramCache lod{};
+		ProgramCache tessellation{};
+		std::vector<std::future<bool>> linked{};
+
+		void destroy();
+		unsigned long long skippedUploads();
+	};
+
+	// state
+	ShaderCompiler* m_compiler{};
+	ProgramBinaryCache* m_binaryCache{};
+	std::string m_directory{};
+	// added to the defines of the cube programs, how they read the instance attribute
+	std::string m_instanceDefines{};
+	ShaderWatcher m_watcher{};
+	// the set that is drawn with and the one being built, both stay in place while the compiler holds their programs
+	std::unique_ptr<ProgramSet> m_current{};
+	std::unique_ptr<ProgramSet> m_pending{};
+	// a file changed while a set was being built, build again once it is done
+	bool m_changedWhilePending{};
+
+	// statistics
+	unsigned int m_reloads{};
+	unsigned int m_failedReloads{};
+	unsigned long long m_retiredSkippedUploads{};
+
+	// reads the sources of the shader directory and submits a new set, nullptr if a file couldn't be read
+	std::unique_ptr<ProgramSet> m_load();
+	std::unique_ptr<ProgramSet> m_submit(std::string vertexSource, std::string fragmentSource);
+	// replaces the current set with the pending one once it has been built, or drops it if it failed
+	void m_finishPending();
+
+public:
+	// constructor
+	RendererPrograms() {  }
+
+	// defines the cube programs of the next submit are built with, for the instance format the renderer uploads
+	void setInstanceDefines(const std::string& defines);
+
+	// submits the programs built from the given sources to the compiler. They are ready once it has finished them
+	void submit(ShaderCompiler& compiler, const char* vertexSource, const char* fragmentSource, ProgramBinaryCache* binaryCache);
+	// like submit, but reads the sources from the shader directory and reloads them whenever they change.
+	// Prints the reason and returns false if the files can't be read or watched
+	bool submitFromDirectory(ShaderCompiler& compiler, const std::string& directory, ProgramBinaryCache* binaryCache);
+
+	// starts rebuilding if a shader file changed and swaps in a rebuilt set that is ready, call between frames
+	void update();
+
+	// deletes every program, waiting for the ones still compiling
+	void destroy();
+
+	// getters
+	ProgramCache& getCubes();
+	ProgramCache& getSampleList();
+	ProgramCache& getMesh();
+	ProgramCache& getLod();
+	// empty without ARB_tessellation_shader
+	ProgramCache& getTessellation();
+	// uniform uploads skipped by all programs because the value was already set, including replaced ones
+	unsigned long long getSkippedUploads();
+	unsigned int getReloadCount();
+	unsigned int getFailedReloadCount();
+};
\ No newline at end of file
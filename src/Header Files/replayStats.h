@@ -0,0 +1,37 @@
+#pragma once
+
+#include <morph.h>
+
+#include <vector>
+
+// Frame time distribution of a benchmark replay. Every frame is filed under
+// the phase of the morph cycle it showed, a single surface or a transition
+// between two, and the summary prints the percentiles of every phase and of
+// the whole run. Unlike FrameStats it keeps every sample, a replay is a few
+// thousand frames at most. After reserve() recording a frame never allocates
+
+class ReplayStats {
+private:
+	struct Sample {
+		int phase{};
+		double frameTime{};
+	};
+
+	// state, the phases in the order they first appeared and every frame in order
+	std::vector<MorphState> m_phases{};
+	std::vector<Sample> m_samples{};
+
+	void m_print(const char* label, std::vector<double> frameTimes);
+
+public:
+	// constructor
+	ReplayStats() {  }
+
+	// makes room for the given number of frames and every phase up front
+	void reserve(int frames);
+	// records the duration of a frame that showed the given morph state
+	void addFrame(const MorphState& state, double frameTime);
+
+	// prints p50, p95, p99 and max frame time per phase and over every frame
+	void printSummary();
+};
\ No newline at end of file
@@ -1,22 +1,97 @@
 #pragma once
 
 #include <string>
+#include <string_view>
+#include <vector>
+
+#include <programBinaryCache.h>
+#include <shaderSources.h>
 
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+// Name of a uniform, hashed when the program is compiled so the lookup in
+// Shader is a table index instead of a glGetUniformLocation string search.
+// String literals are hashed at compile time, other strings with fromString
+struct UniformName {
+	unsigned int hash{};
+
+	template <std::size_t N>
+	consteval UniformName(const char (&name)[N])
+		: hash{ hashOf(std::string_view{ name, N - 1 }) }
+	{
+	}
+
+	static UniformName fromString(std::string_view name) { return UniformName{ hashOf(name), 0 }; }
+
+	// 32 bit FNV-1a
+	static constexpr unsigned int hashOf(std::string_view name) {
+		unsigned int hash{ 2166136261u };
+		for (char c : name) {
+			hash = (hash ^ static_cast<unsigned char>(c)) * 16777619u;
+		}
+		return hash;
+	}
+
+private:
+	constexpr UniformName(unsigned int hash, int)
+		: hash{ hash }
+	{
+	}
+};
+
 // General purpose shader object. Compiles from file, generates
 // compile/link-time error messages and hosts several utility 
 // functions for easy management
+//
+// The active uniforms are read back after linking into a small open
+// addressing table keyed by the name hash. Every entry keeps a copy of the
+// value last uploaded, so setting a uniform to the value it already has
+// costs no GL call
 
 class Shader {
 private:
+	struct Uniform {
+		unsigned int hash{};
+		int location{ -1 };
+		bool uploaded{};
+		// the value last uploaded, large enough for a mat4
+		alignas(16) unsigned char value[64]{};
+	};
+
+	// a compile that was started by beginCompile and not finished yet
+	struct PendingBuild {
+		bool active{};
+		unsigned int stages[5]{};
+		const char* stageNames[5]{};
+		int stageCount{};
+		ProgramBinaryCache* binaryCache{};
+		std::uint64_t binaryKey{};
+	};
+
 	// state
 	unsigned int m_ID{};
+	PendingBuild m_pending{};
+	// power of two sized, unused slots have location -1
+	std::vector<Uniform> m_uniforms{};
+	unsigned long long m_skippedUploads{};
 
 	// checks if compilation or linking failed and if so, print the error logs
 	void m_checkCompileErrors(unsigned int object, std::string type);
+	// starts compiling a single stage, inserting the stage's define and the defines right after its #version line
+	unsigned int m_compileStage(unsigned int stage, const char* source, const char* defines);
+	// adds the stage to the pending build if there is a source for it
+	void m_addStage(unsigned int stage, const char* name, const char* source, const char* defines);
+	// binds the uniform blocks and fills the uniform table of the linked program
+	void m_linked();
+	// fills the uniform table from the active uniforms of the linked program
+	void m_reflectUniforms();
+	// returns the table entry of the uniform, nullptr if the program doesn't use it
+	Uniform* m_find(UniformName name);
+	// uploads the value through upload(location) unless the uniform already holds it
+	template <typename Upload>
+	void m_set(UniformName name, const void* value, std::size_t size, bool useShader, Upload upload);
 
 public:
 	// constructor
@@ -25,22 +100,36 @@ public:
 	// sets the current shader as active
 	Shader& use();
 
-	// compiles the shader from given source code
-	void compile(const char* vertexSource, const char* fragmentSource, const char* geometrySource = nullptr);
+	// compiles the shader from given source code, defines (a block of #define lines) are injected into every stage.
+	// With a binary cache the linked program is loaded from it when possible and stored in it otherwise
+	void compile(const ShaderSources& sources, const char* defines = nullptr, ProgramBinaryCache* binaryCache = nullptr);
+
+	// compile in two halves, so the driver can build several programs at once (see ShaderCompiler):
+	// beginCompile only hands the sources to the driver, finishCompile checks the result, waiting
+	// for it if necessary, and returns whether the program linked
+	void beginCompile(const ShaderSources& sources, const char* defines = nullptr, ProgramBinaryCache* binaryCache = nullptr);
+	// true once finishCompile won't wait, always true without KHR_parallel_shader_compile
+	bool isCompileReady();
+	bool finishCompile();
+
+	// deletes the program, the shader can be compiled again afterwards
+	void destroy();
 
 	// utility functions
-	void setFloat(const char* name, float value, bool useShader = false);
-	void setInteger(const char* name, int value, bool useShader = false);
-	void setVector2f(const char* name, float x, float y, bool useShader = false);
-	void setVector2f(const char* name, const glm::vec2& value, bool useShader = false);
-	void setVector3f(const char* name, float x, float y, float z, bool useShader = false);
-	void setVector3f(const char* name, const glm::vec3& value, bool useShader = false);
-	void setVector4f(const char* name, float x, float y, float z, float w, bool useShader = false);
-	void setVector4f(const char* name, const glm::vec4& value, bool useShader = false);
-	void setMatrix2(const char* name, const glm::mat2& matrix, bool useShader = false);
-	void setMatrix3(const char* name, const glm::mat3& matrix, bool useShader = false);
-	void setMatrix4(const char* name, const glm::mat4& matrix, bool useShader = false);
+	void setFloat(UniformName name, float value, bool useShader = false);
+	void setInteger(UniformName name, int value, bool useShader = false);
+	void setVector2f(UniformName name, float x, float y, bool useShader = false);
+	void setVector2f(UniformName name, const glm::vec2& value, bool useShader = false);
+	void setVector3f(UniformName name, float x, float y, float z, bool useShader = false);
+	void setVector3f(UniformName name, const glm::vec3& value, bool useShader = false);
+	void setVector4f(UniformName name, float x, float y, float z, float w, bool useShader = false);
+	void setVector4f(UniformName name, const glm::vec4& value, bool useShader = false);
+	void setMatrix2(UniformName name, const glm::mat2& matrix, bool useShader = false);
+	void setMatrix3(UniformName name, const glm::mat3& matrix, bool useShader = false);
+	void setMatrix4(UniformName name, const glm::mat4& matrix, bool useShader = false);
 
 	// getters
 	unsigned int getId();
+	// number of setter calls that were skipped because the uniform already had the value
+	unsigned long long getSkippedUploads();
 };
\ No newline at end of file
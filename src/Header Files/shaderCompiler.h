@@ -0,0 +1,63 @@
+#pragma once
+
+#include <shader.h>
+
+#include <future>
+#include <string>
+#include <vector>
+
+// Builds many programs at once instead of one after the other. Every
+// submitted program is handed to the driver right away, and poll() finishes
+// the ones the driver is done with, so the render thread can set up buffers
+// or draw frames while the driver compiles
+//
+// With KHR_parallel_shader_compile (or the ARB version) the driver compiles
+// on its own threads and poll() never waits. Without it there is no way to
+// ask whether a program is done, and the driver may well compile it right
+// in the calls that hand it over. So the programs are queued instead, and
+// every poll() builds only the oldest one, one program per frame while the
+// render loop polls. waitAll() still builds all of them at once
+//
+// All calls, including the ones that resolve the futures, happen on the
+// thread that owns the GL context, so never wait on a future without polling
+
+class ShaderCompiler {
+private:
+	struct Job {
+		Shader* shader{};
+		// kept until the program is handed to the driver, the sources must outlive the job
+		ShaderSources sources{};
+		std::string defines{};
+		ProgramBinaryCache* binaryCache{};
+		bool started{};
+		std::promise<bool> linked{};
+	};
+
+	// state
+	std::vector<Job> m_jobs{};
+	bool m_parallel{};
+
+	// statistics
+	unsigned int m_finished{};
+
+	// hands the program to the driver if it isn't yet, then waits for it and resolves its future
+	void m_finish(Job& job);
+
+public:
+	// constructor, needs a current GL context and lets the driver use as many compiler threads as it likes
+	ShaderCompiler();
+
+	// starts building the program into shader, which has to stay in place until it is finished.
+	// The future is resolved by poll() or waitAll() with whether the program linked
+	std::future<bool> submit(Shader& shader, const ShaderSources& sources, const char* defines = nullptr, ProgramBinaryCache* binaryCache = nullptr);
+
+	// finishes every program the driver is done with, or the oldest one without parallel compilation.
+	// Returns the number still compiling or queued
+	int poll();
+	// finishes every submitted program
+	void waitAll();
+
+	// getters
+	bool isParallel();
+	unsigned int getFinishedCount();
+};
\ No newline at end of file
@@ -0,0 +1,16 @@
+#pragma once
+
+// The sources of the stages of one program. Vertex and fragment are always
+// there, the other stages are left out while their source is nullptr
+//
+// One source may serve several stages: Shader compiles every stage with a
+// define naming it (SHADER_STAGE_VERTEX, SHADER_STAGE_TESS_CONTROL, ...) so
+// the source can pick the declarations and main() of the stage
+
+struct ShaderSources {
+	const char* vertex{};
+	const char* fragment{};
+	const char* geometry{};
+	const char* tessControl{};
+	const char* tessEvaluation{};
+};
\ No newline at end of file
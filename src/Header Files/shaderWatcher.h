@@ -0,0 +1,44 @@
+#pragma once
+
+#include <string>
+#include <utility>
+#include <vector>
+
+// Reports when shader files on disk change, through inotify. The
+// directories of the files are watched rather than the files themselves,
+// since most editors save by writing a new file and renaming it over the old
+// one, which a watch on the file would lose
+//
+// Only available on Linux, watch() fails elsewhere
+
+class ShaderWatcher {
+private:
+	struct Watch {
+		int descriptor{ -1 };
+		std::string directory{};
+	};
+
+	// state
+	int m_fd{ -1 };
+	std::vector<Watch> m_watches{};
+	// directory and name of every watched file
+	std::vector<std::pair<std::string, std::string>> m_files{};
+
+public:
+	// constructor
+	ShaderWatcher() {  }
+	~ShaderWatcher();
+
+	ShaderWatcher(const ShaderWatcher&) = delete;
+	ShaderWatcher& operator=(const ShaderWatcher&) = delete;
+
+	// starts watching the file, prints the reason and returns false if that isn't possible
+	bool watch(const std::string& path);
+
+	// true if a watched file was written or replaced since the last call, never blocks
+	bool poll();
+
+	// reads a shader file into source. Files written for CPP_SHADER_INCLUDE are reduced to
+	// the GLSL inside their raw string literal, so the same files work both ways
+	static bool readSource(const std::string& path, std::string& source);
+};
\ No newline at end of file
@@ -0,0 +1,182 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SIMD_SSE2
+#endif
+
+// Thin wrapper around the widest float vector the target was compiled for:
+// 8 lanes with AVX2, 4 lanes with SSE2, otherwise a single scalar lane.
+// Kernels are written once against Simd::Float and compiled for any width.
+
+namespace Simd {
+#if defined(__AVX2__)
+	static inline constexpr int WIDTH{ 8 };
+	static inline constexpr const char* NAME{ "AVX2" };
+	// alignment stream() needs
+	static inline constexpr int ALIGNMENT{ 32 };
+
+	struct Float { __m256 v; };
+	struct Int { __m256i v; };
+
+	inline Float broadcast(float x) { return { _mm256_set1_ps(x) }; }
+	inline Float iota() { return { _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f) }; }
+	inline Float load(const float* p) { return { _mm256_loadu_ps(p) }; }
+	inline void store(float* p, Float a) { _mm256_storeu_ps(p, a.v); }
+	// non-temporal store straight to memory past the caches, p aligned to ALIGNMENT
+	inline void stream(float* p, Float a) { _mm256_stream_ps(p, a.v); }
+	// orders the streaming stores before any store that follows, call before another thread reads the data
+	inline void streamFence() { _mm_sfence(); }
+
+	inline Float operator+(Float a, Float b) { return { _mm256_add_ps(a.v, b.v) }; }
+	inline Float operator-(Float a, Float b) { return { _mm256_sub_ps(a.v, b.v) }; }
+	inline Float operator*(Float a, Float b) { return { _mm256_mul_ps(a.v, b.v) }; }
+	inline Float operator/(Float a, Float b) { return { _mm256_div_ps(a.v, b.v) }; }
+#if defined(__FMA__)
+	inline Float mulAdd(Float a, Float b, Float c) { return { _mm256_fmadd_ps(a.v, b.v, c.v) }; }
+#else
+	inline Float mulAdd(Float a, Float b, Float c) { return { _mm256_add_ps(_mm256_mul_ps(a.v, b.v), c.v) }; }
+#endif
+	inline Float sqrt(Float a) { return { _mm256_sqrt_ps(a.v) }; }
+	inline Float min(Float a, Float b) { return { _mm256_min_ps(a.v, b.v) }; }
+	inline Float max(Float a, Float b) { return { _mm256_max_ps(a.v, b.v) }; }
+
+	// integer helpers used by the range reduction of sin/cos and the packed instance formats
+	inline Int roundToInt(Float a) { return { _mm256_cvtps_epi32(a.v) }; }
+	inline Float toFloat(Int a) { return { _mm256_cvtepi32_ps(a.v) }; }
+	inline Int operator&(Int a, int b) { return { _mm256_and_si256(a.v, _mm256_set1_epi32(b)) }; }
+	inline Int operator+(Int a, int b) { return { _mm256_add_epi32(a.v, _mm256_set1_epi32(b)) }; }
+	inline Int operator|(Int a, Int b) { return { _mm256_or_si256(a.v, b.v) }; }
+	inline Int broadcastInt(std::int32_t x) { return { _mm256_set1_epi32(x) }; }
+	inline Int loadInt(const std::int32_t* p) { return { _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)) }; }
+	inline void storeInt(std::int32_t* p, Int a) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), a.v); }
+	inline void streamInt(std::int32_t* p, Int a) { _mm256_stream_si256(reinterpret_cast<__m256i*>(p), a.v); }
+	// flips the sign of every lane of a where bit 1 of quadrant is set
+	inline Float flipSign(Float a, Int quadrant) {
+		return { _mm256_xor_ps(a.v, _mm256_castsi256_ps(_mm256_slli_epi32((quadrant & 2).v, 30))) };
+	}
+	// picks b in every lane where bit 0 of quadrant is set, a otherwise
+	inline Float selectOdd(Float a, Float b, Int quadrant) {
+		__m256 odd{ _mm256_castsi256_ps(_mm256_cmpeq_epi32((quadrant & 1).v, _mm256_set1_epi32(1))) };
+		return { _mm256_blendv_ps(a.v, b.v, odd) };
+	}
+#elif defined(SIMD_SSE2)
+	static inline constexpr int WIDTH{ 4 };
+	static inline constexpr const char* NAME{ "SSE2" };
+	static inline constexpr int ALIGNMENT{ 16 };
+
+	struct Float { __m128 v; };
+	struct Int { __m128i v; };
+
+	inline Float broadcast(float x) { return { _mm_set1_ps(x) }; }
+	inline Float iota() { return { _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f) }; }
+	inline Float load(const float* p) { return { _mm_loadu_ps(p) }; }
+	inline void store(float* p, Float a) { _mm_storeu_ps(p, a.v); }
+	inline void stream(float* p, Float a) { _mm_stream_ps(p, a.v); }
+	inline void streamFence() { _mm_sfence(); }
+
+	inline Float operator+(Float a, Float b) { return { _mm_add_ps(a.v, b.v) }; }
+	inline Float operator-(Float a, Float b) { return { _mm_sub_ps(a.v, b.v) }; }
+	inline Float operator*(Float a, Float b) { return { _mm_mul_ps(a.v, b.v) }; }
+	inline Float operator/(Float a, Float b) { return { _mm_div_ps(a.v, b.v) }; }
+	inline Float mulAdd(Float a, Float b, Float c) { return { _mm_add_ps(_mm_mul_ps(a.v, b.v), c.v) }; }
+	inline Float sqrt(Float a) { return { _mm_sqrt_ps(a.v) }; }
+	inline Float min(Float a, Float b) { return { _mm_min_ps(a.v, b.v) }; }
+	inline Float max(Float a, Float b) { return { _mm_max_ps(a.v, b.v) }; }
+
+	inline Int roundToInt(Float a) { return { _mm_cvtps_epi32(a.v) }; }
+	inline Float toFloat(Int a) { return { _mm_cvtepi32_ps(a.v) }; }
+	inline Int operator&(Int a, int b) { return { _mm_and_si128(a.v, _mm_set1_epi32(b)) }; }
+	inline Int operator+(Int a, int b) { return { _mm_add_epi32(a.v, _mm_set1_epi32(b)) }; }
+	inline Int operator|(Int a, Int b) { return { _mm_or_si128(a.v, b.v) }; }
+	inline Int broadcastInt(std::int32_t x) { return { _mm_set1_epi32(x) }; }
+	inline Int loadInt(const std::int32_t* p) { return { _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)) }; }
+	inline void storeInt(std::int32_t* p, Int a) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), a.v); }
+	inline void streamInt(std::int32_t* p, Int a) { _mm_stream_si128(reinterpret_cast<__m128i*>(p), a.v); }
+	inline Float flipSign(Float a, Int quadrant) {
+		return { _mm_xor_ps(a.v, _mm_castsi128_ps(_mm_slli_epi32((quadrant & 2).v, 30))) };
+	}
+	inline Float selectOdd(Float a, Float b, Int quadrant) {
+		__m128 odd{ _mm_castsi128_ps(_mm_cmpeq_epi32((quadrant & 1).v, _mm_set1_epi32(1))) };
+		return { _mm_or_ps(_mm_and_ps(odd, b.v), _mm_andnot_ps(odd, a.v)) };
+	}
+#else
+	static inline constexpr int WIDTH{ 1 };
+	static inline constexpr const char* NAME{ "scalar" };
+	static inline constexpr int ALIGNMENT{ 4 };
+
+	struct Float { float v; };
+	struct Int { std::int32_t v; };
+
+	inline Float broadcast(float x) { return { x }; }
+	inline Float iota() { return { 0.0f }; }
+	inline Float load(const float* p) { return { *p }; }
+	inline void store(float* p, Float a) { *p = a.v; }
+	inline void stream(float* p, Float a) { *p = a.v; }
+	inline void streamFence() {  }
+
+	inline Float operator+(Float a, Float b) { return { a.v + b.v }; }
+	inline Float operator-(Float a, Float b) { return { a.v - b.v }; }
+	inline Float operator*(Float a, Float b) { return { a.v * b.v }; }
+	inline Float operator/(Float a, Float b) { return { a.v / b.v }; }
+	inline Float mulAdd(Float a, Float b, Float c) { return { a.v * b.v + c.v }; }
+	inline Float sqrt(Float a) { return { std::sqrt(a.v) }; }
+	inline Float min(Float a, Float b) { return { a.v < b.v ? a.v : b.v }; }
+	inline Float max(Float a, Float b) { return { a.v > b.v ? a.v : b.v }; }
+
+	inline Int roundToInt(Float a) { return { static_cast<std::int32_t>(a.v < 0.0f ? a.v - 0.5f : a.v + 0.5f) }; }
+	inline Float toFloat(Int a) { return { static_cast<float>(a.v) }; }
+	inline Int operator&(Int a, int b) { return { a.v & b }; }
+	inline Int operator+(Int a, int b) { return { a.v + b }; }
+	inline Int operator|(Int a, Int b) { return { a.v | b.v }; }
+	inline Int broadcastInt(std::int32_t x) { return { x }; }
+	inline Int loadInt(const std::int32_t* p) { return { *p }; }
+	inline void storeInt(std::int32_t* p, Int a) { *p = a.v; }
+	inline void streamInt(std::int32_t* p, Int a) { *p = a.v; }
+	inline Float flipSign(Float a, Int quadrant) { return { (quadrant.v & 2) ? -a.v : a.v }; }
+	inline Float selectOdd(Float a, Float b, Int quadrant) { return { (quadrant.v & 1) ? b.v : a.v }; }
+#endif
+
+	inline Float operator-(Float a) { return broadcast(0.0f) - a; }
+
+	// sine and cosine of every lane. The argument is reduced to [-PI/4, PI/4]
+	// around the nearest multiple of PI/2 (split in three parts to keep the
+	// reduction exact) and both minimax polynomials are evaluated on it.
+	// Absolute error is below 1e-6 for |x| up to a few thousand.
+	inline void sinCos(Float x, Float& sine, Float& cosine) {
+		Int quadrant{ roundToInt(x * broadcast(0.63661977236f)) };
+		Float k{ toFloat(quadrant) };
+		Float r{ mulAdd(k, broadcast(-1.5703125f), x) };
+		r = mulAdd(k, broadcast(-4.837512969970703125e-4f), r);
+		r = mulAdd(k, broadcast(-7.54978995489188216e-8f), r);
+		Float z{ r * r };
+
+		Float s{ mulAdd(z, broadcast(-1.9515295891e-4f), broadcast(8.3321608736e-3f)) };
+		s = mulAdd(s, z, broadcast(-1.6666654611e-1f));
+		s = mulAdd(s * z, r, r);
+
+		Float c{ mulAdd(z, broadcast(2.443315711809948e-5f), broadcast(-1.388731625493765e-3f)) };
+		c = mulAdd(c, z, broadcast(4.166664568298827e-2f));
+		c = mulAdd(c * z, z, mulAdd(z, broadcast(-0.5f), broadcast(1.0f)));
+
+		sine = flipSign(selectOdd(s, c, quadrant), quadrant);
+		cosine = flipSign(selectOdd(c, s, quadrant), quadrant + 1);
+	}
+
+	inline Float sin(Float x) {
+		Float sine{}, cosine{};
+		sinCos(x, sine, cosine);
+		return sine;
+	}
+
+	inline Float cos(Float x) {
+		Float sine{}, cosine{};
+		sinCos(x, sine, cosine);
+		return cosine;
+	}
+}
\ No newline at end of file
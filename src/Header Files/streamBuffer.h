@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+
+#include <glad/glad.h>
+
+// Ring buffer for data that is rewritten every frame. The buffer is split
+// into regions so the CPU can fill one region while the GPU is still reading
+// the ones submitted in previous frames. Each region is guarded by a fence.
+//
+// When GL_ARB_buffer_storage is available the whole buffer is persistently
+// mapped once; otherwise every region is mapped unsynchronised with
+// glMapBufferRange and the buffer is orphaned instead of waiting on the GPU.
+
+class StreamBuffer {
+private:
+	static inline constexpr unsigned int MAX_REGIONS{ 4 };
+
+	// state
+	unsigned int m_ID{};
+	unsigned int m_target{};
+	std::size_t m_regionSize{};
+	unsigned int m_regionCount{};
+	unsigned int m_current{};
+	bool m_persistent{};
+	unsigned char* m_persistentPtr{};
+	GLsync m_fences[MAX_REGIONS]{};
+
+	// statistics
+	bool m_lastMapStalled{};
+	unsigned int m_stallCount{};
+	unsigned int m_orphanCount{};
+
+	// returns true if the GPU is done with the given region, never blocks
+	bool m_isRegionFree(unsigned int region);
+	// blocks until the GPU is done with the given region
+	void m_waitForRegion(unsigned int region);
+	void m_deleteFences();
+
+public:
+	// constructor
+	StreamBuffer() {  }
+
+	// allocates regionCount regions of (at least) regionSize bytes each
+	void create(unsigned int target, std::size_t regionSize, unsigned int regionCount = 3);
+	void destroy();
+
+	// returns a pointer to the region for this frame, ready to be written
+	void* map();
+	// finishes writing and returns the byte offset of the region in the buffer
+	std::size_t unmap();
+	// call after the draws that read the current region, advances to the next region
+	void fence();
+
+	// getters
+	unsigned int getId();
+	bool isPersistent();
+	bool lastMapStalled();
+	unsigned int getStallCount();
+	unsigned int getOrphanCount();
+};
\ No newline at end of file
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <surfaces.h>
+#include <jobSystem.h>
+
+#include <glm/glm.hpp>
+
+#include <memory>
+#include <vector>
+
+// Evaluates a surface over a whole grid at once. Rows are spread over a
+// job system and every row is evaluated Simd::WIDTH samples at a time, so
+// this is the path for bulk work without a GPU: analytics, export, culling
+//
+// Most surface terms are sines of sums of a u-only and a v-only angle. With
+// the separable method those are expanded with the angle-addition identity
+// sin(a + b) = sin(a) cos(b) + cos(a) sin(b): sin and cos of every column
+// and row angle are tabulated once per call, and every sample is built from
+// multiply-adds of table entries. Ripple depends on sqrt(u * u + v * v) and
+// is always evaluated directly. Run surfaces-bench for speed and error
+// figures on the current machine.
+//
+// The library is built for one vector unit, AVX2 and FMA unless the build
+// turns them off (xmake f --avx2=n), and has no fallback at runtime. Code
+// outside the library asks it with getVectorUnit() instead of including
+// simd.h, which would be compiled for its own target
+
+class SurfaceEvaluator {
+public:
+	// how the samples of a grid are computed
+	enum class Method {
+		direct,		// every sample evaluates the full formula
+		separable,	// separable terms are built from per-row and per-column tables
+	};
+
+private:
+	// where a batch of samples goes, either separate x/y/z arrays or interleaved points
+	struct Output {
+		float* x{};
+		float* y{};
+		float* z{};
+		glm::vec3* points{};
+	};
+
+	// state
+	// set when the evaluator made its own job system instead of sharing one
+	std::unique_ptr<JobSystem> m_ownedJobs{};
+	JobSystem& m_jobs;
+	Method m_method{ Method::separable };
+	// sin/cos tables of the separable method, rebuilt by every call
+	std::vector<float> m_columnTables{};
+	std::vector<float> m_rowTables{};
+
+	void m_evaluate(Surfaces::Surface surface, const SurfaceGrid& grid, float t, const Output& output);
+
+public:
+	// constructor, zero threads means one per hardware thread
+	SurfaceEvaluator(unsigned int threadCount = 0)
+		: m_ownedJobs{ std::make_unique<JobSystem>(threadCount) }
+		, m_jobs{ *m_ownedJobs }
+	{
+	}
+	// constructor, spreads the rows over a job system shared with other work
+	SurfaceEvaluator(JobSystem& jobs)
+		: m_jobs{ jobs }
+	{
+	}
+
+	// writes grid.size() samples into each of x, y and z, row after row
+	void evaluate(Surfaces::Surface surface, const SurfaceGrid& grid, float t, float* x, float* y, float* z);
+	// writes grid.size() interleaved samples, row after row
+	void evaluate(Surfaces::Surface surface, const SurfaceGrid& grid, float t, glm::vec3* points);
+
+	// evaluates rows [rowBegin, rowEnd) on the calling thread only, always with the direct method
+	static void evaluateRows(Surfaces::Surface surface, const SurfaceGrid& grid, float t, int rowBegin, int rowEnd,
+		float* x, float* y, float* z);
+
+	// returns true if the separable method applies to the surface
+	static bool isSeparable(Surfaces::Surface surface);
+
+	// the vector unit the library was built for and its float lanes
+	static const char* getVectorUnit();
+	static int getVectorWidth();
+	// whether this CPU has the vector unit, nothing in the library may run if not
+	static bool isVectorUnitSupported();
+
+	// getters and setters
+	unsigned int getThreadCount();
+	// the job system the rows are spread over, free for other loops between evaluations
+	JobSystem& getJobs();
+	Method getMethod();
+	void setMethod(Method method);
+};
\ No newline at end of file
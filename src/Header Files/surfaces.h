@@ -0,0 +1,64 @@
+#pragma once
+
+#include <interval.h>
+
+#include <glm/glm.hpp>
+
+// CPU mirror of the surface functions in position.vert. Every surface maps a
+// grid coordinate (u, v) and the time t to the centre of one cube. The
+// formulas are written once and evaluated on floats for points and on
+// intervals for bounds
+
+namespace Surfaces {
+	enum class Surface {
+		wave,
+		multiWave,
+		ripple,
+		sphere,
+		torus,
+	};
+
+	static inline constexpr int COUNT{ 5 };
+	// same value as the PI constant in position.vert
+	static inline constexpr float PI{ 3.1415926f };
+	// edge length of every cube in grid steps, a little over one so neighbouring cubes overlap without gaps
+	static inline constexpr float CUBE_SIZE{ 1.06f };
+
+	glm::vec3 wave(float u, float v, float t);
+	glm::vec3 multiWave(float u, float v, float t);
+	glm::vec3 ripple(float u, float v, float t);
+	glm::vec3 sphere(float u, float v, float t);
+	glm::vec3 torus(float u, float v, float t);
+
+	glm::vec3 evaluate(Surface surface, float u, float v, float t);
+	const char* name(Surface surface);
+
+	// axis aligned box
+	struct Bounds {
+		glm::vec3 min{};
+		glm::vec3 max{};
+	};
+
+	// guaranteed bounds of every point the surface reaches over the box of u, v and t,
+	// from evaluating its formula in interval arithmetic
+	Bounds bounds(Surface surface, Interval u, Interval v, Interval t);
+}
+
+// A regular grid of samples: sample (column, row) sits at
+// u = uStart + column * uStep and v = vStart + row * vStep
+struct SurfaceGrid {
+	int columns{};
+	int rows{};
+	float uStart{};
+	float vStart{};
+	float uStep{};
+	float vStep{};
+
+	// the grid drawn by the renderer, width * width instances around the origin with u and v
+	// spanning [-1, 1] whatever the width
+	static SurfaceGrid instanceGrid(int width);
+
+	int size() const { return columns * rows; }
+	// edge length of the cube drawn at every sample, the scale of the surface matrices in position.vert
+	float cubeSize() const { return uStep * Surfaces::CUBE_SIZE; }
+};
\ No newline at end of file
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <surfaces.h>
+#include <morph.h>
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+// The coarse patches of the tessellation mode. The u/v domain of the grid is
+// split into patches x patches quads, each submitted as one four vertex
+// patch that the tessellation stages of position.vert refine on the GPU.
+// How finely a patch edge is split depends on the edge alone, its length on
+// screen and how far the surface bends away from it, so neighbouring patches
+// always split their shared edge alike and the surface has no cracks
+//
+// The patches are culled against the view frustum with the bounds of the
+// morph state like the tiles, only the indices of the visible ones are
+// uploaded
+
+class TessellationPatches {
+public:
+	// patches along each side of the grid
+	static inline constexpr int DEFAULT_PATCHES{ 32 };
+	// the largest distance on screen in pixels between the tessellated and the true surface
+	static inline constexpr float DEFAULT_PIXEL_ERROR{ 0.5f };
+	// the longest edge on screen in pixels the tessellated triangles may have
+	static inline constexpr float MAX_EDGE_PIXELS{ 16.0f };
+
+private:
+	// state
+	SurfaceGrid m_grid{};
+	int m_patches{};
+	std::vector<unsigned int> m_visible{};
+
+	// statistics
+	unsigned int m_frames{};
+	unsigned long long m_visiblePatches{};
+
+public:
+	// constructor, the patches span the grid from its first to its last sample
+	TessellationPatches(const SurfaceGrid& grid, int patches = DEFAULT_PATCHES);
+
+	// culls every patch against the frustum of viewProjection and returns the indices of the visible ones,
+	// row after row
+	const std::vector<unsigned int>& cull(const MorphState& state, float t, const glm::mat4& viewProjection);
+
+	// u and v of the first sample, then of the last one
+	glm::vec4 getDomain();
+
+	// prints the share of patches drawn over every cull so far
+	void printSummary();
+
+	// getters
+	// patches along each side
+	int getPatches();
+	int getPatchCount();
+};
\ No newline at end of file
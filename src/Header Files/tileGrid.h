@@ -0,0 +1,66 @@
+#pragma once
+
+#include <surfaces.h>
+#include <morph.h>
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+// Splits the instance grid into square tiles of samples and culls them
+// against the view frustum. Every tile gets a conservative box from the
+// bounds of the current morph state, and only the tiles whose box can be
+// on screen are drawn
+//
+// The instances are ordered tile after tile (see sampleOrder), so every tile
+// is one contiguous range of instances and neighbouring visible tiles merge
+// into a single range
+
+class TileGrid {
+public:
+	static inline constexpr int DEFAULT_TILE_SIZE{ 64 };
+
+	// a contiguous run of instances in tile order
+	struct Range {
+		unsigned int first{};
+		unsigned int count{};
+	};
+
+private:
+	struct Tile {
+		int columnBegin{};
+		int columnEnd{};
+		int rowBegin{};
+		int rowEnd{};
+		Range instances{};
+	};
+
+	// state
+	SurfaceGrid m_grid{};
+	std::vector<Tile> m_tiles{};
+	std::vector<Range> m_ranges{};
+
+	// statistics
+	unsigned int m_frames{};
+	unsigned long long m_visibleTiles{};
+	unsigned long long m_drawnInstances{};
+	unsigned int m_lastVisibleTiles{};
+
+public:
+	// constructor, tiles at the right and bottom edge may be smaller than tileSize
+	TileGrid(const SurfaceGrid& grid, int tileSize = DEFAULT_TILE_SIZE);
+
+	// the sample index of every instance, tile after tile, for instances [first, first + count) of that order.
+	// A chunk of a large grid only needs its own run
+	std::vector<unsigned int> sampleOrder(std::size_t first, std::size_t count) const;
+
+	// culls every tile against the frustum of viewProjection and returns the instance ranges of the visible ones
+	const std::vector<Range>& cull(const MorphState& state, float t, const glm::mat4& viewProjection);
+
+	// prints the share of tiles and instances drawn over every cull so far
+	void printSummary();
+
+	// getters
+	int getTileCount();
+	unsigned int getLastVisibleTiles();
+};
\ No newline at end of file
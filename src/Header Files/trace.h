@@ -0,0 +1,76 @@
+#pragma once
+
+// Scoped timing zones for the hot paths of the render loop, written as a
+// Chrome trace (chrome://tracing or https://ui.perfetto.dev) on exit
+//
+//   TRACE_ZONE("fill instances");       CPU time of the enclosing scope
+//   TRACE_GPU_ZONE("draw cubes");       CPU time plus the GPU time of the commands issued in the scope
+//
+// The macros compile to nothing unless the build defines ENABLE_TRACING, and
+// record nothing until Trace::start is called
+//
+// Every thread writes its zones into its own ring buffer, so recording takes
+// no locks; only the newest RING_CAPACITY zones of a thread are kept. GPU
+// zones are a pair of GL_TIMESTAMP queries that are read back QUERY_LATENCY
+// frames later, by which time the results are available and reading them
+// never waits for the GPU. Results that still aren't there are dropped. The
+// queries of MAX_GPU_ZONES zones per frame are made by start(), so recording
+// never allocates, and zones past that number in a frame are dropped too
+
+#ifdef ENABLE_TRACING
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_ZONE(name) Trace::CpuZone TRACE_CONCAT(traceZone, __LINE__){ name }
+#define TRACE_GPU_ZONE(name) Trace::CpuZone TRACE_CONCAT(traceZone, __LINE__){ name }; Trace::GpuZone TRACE_CONCAT(traceGpuZone, __LINE__){ name }
+#else
+#define TRACE_ZONE(name) ((void)0)
+#define TRACE_GPU_ZONE(name) ((void)0)
+#endif
+
+#include <string>
+
+namespace Trace {
+	static inline constexpr unsigned int RING_CAPACITY{ 1 << 16 };
+	static inline constexpr int MAX_THREADS{ 64 };
+	static inline constexpr int QUERY_LATENCY{ 4 };
+	static inline constexpr int MAX_GPU_ZONES{ 256 };
+
+	// starts recording, needs the GL context to line up the GPU clock with the CPU clock.
+	// Prints the reason and returns false if the build has no tracing
+	bool start();
+	// reads back the GPU zones of an earlier frame, call once per frame after swapping buffers
+	void endFrame();
+	// stops recording and writes every kept zone as Chrome trace JSON, prints the reason and returns false on failure
+	bool stop(const std::string& path);
+
+	bool isEnabled();
+
+	// records the wall time from construction to destruction on the calling thread
+	class CpuZone {
+	private:
+		const char* m_name{};
+		long long m_start{ -1 };
+
+	public:
+		// constructor, the name has to outlive the trace, a string literal
+		CpuZone(const char* name);
+		~CpuZone();
+
+		CpuZone(const CpuZone&) = delete;
+		CpuZone& operator=(const CpuZone&) = delete;
+	};
+
+	// records the GPU time of the commands issued from construction to destruction, render thread only
+	class GpuZone {
+	private:
+		int m_query{ -1 };
+
+	public:
+		// constructor, the name has to outlive the trace, a string literal
+		GpuZone(const char* name);
+		~GpuZone();
+
+		GpuZone(const GpuZone&) = delete;
+		GpuZone& operator=(const GpuZone&) = delete;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <atomic>
+
+// Wait-free hand over of whole values from one producer thread to one
+// consumer thread. Of the three slots the producer owns one (back), the
+// consumer owns one (front) and the third (middle) is the latest value the
+// producer finished. publish() swaps back and middle, update() swaps middle
+// and front if the middle holds something new, both with a single atomic
+// exchange, so neither side ever waits for the other and the consumer always
+// has the newest complete value. Values the consumer never picks up are
+// simply overwritten
+//
+// The slots are reused, so a T that owns memory (a std::vector) keeps it and
+// publishing never allocates
+
+template <typename T>
+class TripleBuffer {
+private:
+	static inline constexpr unsigned int INDEX_MASK{ 3 };
+	// set in m_middle while the middle slot holds a value the consumer hasn't taken
+	static inline constexpr unsigned int FRESH{ 4 };
+
+	// state
+	T m_slots[3]{};
+	// on separate cache lines, so the two threads don't share one they both write
+	alignas(64) std::atomic<unsigned int> m_middle{ 1 };
+	alignas(64) unsigned int m_back{ 0 };
+	alignas(64) unsigned int m_front{ 2 };
+
+public:
+	// constructor, every slot starts as a copy of initial
+	TripleBuffer(const T& initial = T{})
+		: m_slots{ initial, initial, initial }
+	{
+	}
+
+	TripleBuffer(const TripleBuffer&) = delete;
+	TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+	// before either thread uses the buffer: calls function on every slot, to size the values in place
+	template <typename Function>
+	void forEachSlot(Function function) {
+		for (T& slot : m_slots) {
+			function(slot);
+		}
+	}
+
+	// producer: the slot to write the next value into
+	T& getBack() { return m_slots[m_back]; }
+	// producer: hands the back slot to the consumer and takes the previous middle slot as the new back
+	void publish() {
+		m_back = m_middle.exchange(m_back | FRESH, std::memory_order_acq_rel) & INDEX_MASK;
+	}
+
+	// consumer: takes the newest published value if there is one, returns whether the front changed
+	bool update() {
+		if ((m_middle.load(std::memory_order_relaxed) & FRESH) == 0) {
+			return false;
+		}
+		m_front = m_middle.exchange(m_front, std::memory_order_acq_rel) & INDEX_MASK;
+		return true;
+	}
+	// consumer: the value taken by the last update()
+	const T& getFront() const { return m_slots[m_front]; }
+};
\ No newline at end of file
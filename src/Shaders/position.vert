@@ -1,18 +1,71 @@
 #ifdef CPP_SHADER_INCLUDE
 const char* positionVert = R"(#version 330 core
+// with SURFACE_TESSELLATION this source is also the tessellation control and evaluation stage
+#if defined(SHADER_STAGE_TESS_CONTROL) || defined(SHADER_STAGE_TESS_EVALUATION)
+#extension GL_ARB_tessellation_shader : require
+#endif
+#ifdef SURFACE_TESSELLATION
+#ifdef SHADER_STAGE_VERTEX
+layout (location = 4) in uint patchIndex; // the coarse patch, see tessellationPatches.h
+#endif
+#else
 layout (location = 0) in vec3 aPos;
 layout (location = 2) in vec2 aTexCoords;
+// the instance, unused with proceduralInstances. The compact formats leave out the time, it is the same for every instance
+#if defined(INSTANCE_SHORT2)
+layout (location = 3) in ivec2 instanceXZ; // x = xIndex, y = zIndex
+#elif defined(INSTANCE_HALF2)
+layout (location = 3) in vec2 instanceXZ; // x = xIndex, y = zIndex
+#elif defined(INSTANCE_PACKED)
+layout (location = 3) in uint instanceXZ; // column in the low 16 bits, row in the high 16 bits
+#else
 layout (location = 3) in vec3 xTimeZ; // x = xIndex, y = deltaTime, z = zIndex
+#endif
+layout (location = 4) in uint sampleIndex; // grid sample of the instance, only used with SAMPLE_LIST
+#ifdef SURFACE_LOD
+// the patch of a level of detail node, see lodQuadtree.h
+layout (location = 5) in vec3 patchStartStep; // u and v of the first vertex, and the step between vertices
+layout (location = 6) in vec2 patchMorph; // camera distances between which the vertices morph into the parent patch's
+#endif
+#endif
 
 const float PI = 3.1415926;
 
+#if !defined(SURFACE_TESSELLATION) || defined(SHADER_STAGE_TESS_EVALUATION)
 out vec3 FragPos;
 out vec2 TexCoords;
+#endif
 
-uniform mat4 projection;
-uniform mat4 view;
+// written once per frame and shared by every program, see frameUniforms.h
+layout (std140) uniform FrameData {
+	mat4 view;
+	mat4 projection;
+	mat4 viewProjection;
+	vec4 cameraPosition;
+	float time;
+	float morphBlend;
+	float morphWeight;
+	int gridWidth;
+	int morphFrom;
+	int morphTo;
+	float gridStep;
+	float scale;
+};
 
-const float scale = 0.0015;
+// when set the grid coordinates come from gl_InstanceID and time from the frame data instead of xTimeZ
+uniform bool proceduralInstances;
+// the grid is drawn in chunks of rows, gl_InstanceID and the listed samples count from the first sample of the chunk
+uniform int firstSample;
+// quads along the side of a level of detail patch, and the u and v of the last sample of the grid the patches are clamped to
+uniform int patchQuads;
+uniform vec2 lodEnd;
+// the coarse patches along each side, and u and v of the first and the last sample they span
+uniform int tessPatches;
+uniform vec4 tessDomain;
+// the largest distance on screen between the tessellated and the true surface, and the longest edge, in pixels
+uniform float tessPixelError;
+uniform float tessEdgePixels;
+uniform vec2 viewportSize;
 
 mat4 plane(float u, float v, float t) {
 
@@ -102,57 +155,174 @@ mat4 torus(float u, float v, float t) {
 	);
 }
 
-float u = xTimeZ.x * sqrt(2.0007) / 1000;
-float v = xTimeZ.z * sqrt(2.0007) / 1000;
-
 mat4 mixMat4(mat4 matA, mat4 matB, float t) {
 	t = smoothstep(0.0, 1.0, t);
 	return (matA * (1.0 - t)) + (matB * t);
 }
 
-void main() {
-	if (int(xTimeZ.y) % 20 < 3) {
-		gl_Position = projection * view * wave(u, v, xTimeZ.y) * vec4(aPos, 1.0);
-		FragPos = vec3(wave(u, v, xTimeZ.y) * vec4(aPos, 1.0));
-	} 
-	else if (int(xTimeZ.y) % 20 == 3) {
-		gl_Position = projection * view * mixMat4(wave(u, v, xTimeZ.y), multiWave(u, v, xTimeZ.y), xTimeZ.y - floor(xTimeZ.y)) * vec4(aPos, 1.0);
-		FragPos = vec3(mixMat4(wave(u, v, xTimeZ.y), multiWave(u, v, xTimeZ.y), xTimeZ.y - floor(xTimeZ.y)) * vec4(aPos, 1.0));
-	}
-	else if (int(xTimeZ.y) % 20 < 7) {
-		gl_Position = projection * view * multiWave(u, v, xTimeZ.y) * vec4(aPos, 1.0);
-		FragPos = vec3(multiWave(u, v, xTimeZ.y) * vec4(aPos, 1.0));
-	} 
-	else if (int(xTimeZ.y) % 20 == 7) {
-		gl_Position = projection * view * mixMat4(multiWave(u, v, xTimeZ.y), ripple(u, v, xTimeZ.y), xTimeZ.y - floor(xTimeZ.y)) * vec4(aPos, 1.0);
-		FragPos = vec3(mixMat4(multiWave(u, v, xTimeZ.y), ripple(u, v, xTimeZ.y), xTimeZ.y - floor(xTimeZ.y)) * vec4(aPos, 1.0));
+// every program is specialised for one morph state by ProgramCache:
+// SURFACE_FROM alone, or SURFACE_FROM blending into SURFACE_TO by morphBlend
+#ifndef SURFACE_FROM
+#define SURFACE_FROM wave
+#endif
+
+mat4 surface(float u, float v, float t) {
+#ifdef SURFACE_TO
+	return mixMat4(SURFACE_FROM(u, v, t), SURFACE_TO(u, v, t), morphBlend);
+#else
+	return SURFACE_FROM(u, v, t);
+#endif
+}
+
+#ifdef SURFACE_TESSELLATION
+#if defined(SHADER_STAGE_TESS_CONTROL)
+layout (vertices = 4) out;
+
+in vec2 cornerUV[];
+out vec2 controlUV[];
+// the level of the edge that ends at the corner, shared with invocation 0
+out float edgeLevels[];
+
+// the sample in pixels from the centre of the screen, w < 0 if it is behind the camera
+vec3 toScreen(vec2 uv) {
+	vec4 clip = viewProjection * surface(uv.x, uv.y, time)[3];
+	return vec3(clip.xy / clip.w * 0.5 * viewportSize, clip.w);
+}
+
+// pieces for an error of distance pixels, which shrinks with the square of the number of pieces
+float curvatureLevel(float distance) {
+	return sqrt(distance / tessPixelError);
+}
+
+// how many pieces the edge from a to b is split into. Only depends on the edge, and the ends are put in
+// a fixed order first, so the patches on either side of an edge always agree on it
+float edgeLevel(vec2 a, vec2 b) {
+	if (a.x > b.x || (a.x == b.x && a.y > b.y)) {
+		vec2 swapped = a;
+		a = b;
+		b = swapped;
 	}
-	else if (int(xTimeZ.y) % 20 < 11) {
-		gl_Position = projection * view * ripple(u, v, xTimeZ.y) * vec4(aPos, 1.0);
-		FragPos = vec3(ripple(u, v, xTimeZ.y) * vec4(aPos, 1.0));
-	} 
-	else if (int(xTimeZ.y) % 20 == 11) {
-		gl_Position = projection * view * mixMat4(ripple(u, v, xTimeZ.y), sphere(u, v, xTimeZ.y), xTimeZ.y - floor(xTimeZ.y)) * vec4(aPos, 1.0);
-		FragPos = vec3(mixMat4(ripple(u, v, xTimeZ.y), sphere(u, v, xTimeZ.y), xTimeZ.y - floor(xTimeZ.y)) * vec4(aPos, 1.0));
+	vec3 screenA = toScreen(a);
+	vec3 screenB = toScreen(b);
+	float level = distance(screenA.xy, screenB.xy) / tessEdgePixels;
+	bool behind = screenA.z <= 0.0 || screenB.z <= 0.0;
+	// the curvature shows as the distance of the surface between the ends from the straight edge
+	for (int i = 1; i < 4; ++i) {
+		float share = float(i) * 0.25;
+		vec3 between = toScreen(mix(a, b, share));
+		behind = behind || between.z <= 0.0;
+		level = max(level, curvatureLevel(distance(between.xy, mix(screenA.xy, screenB.xy, share))));
 	}
-	else if (int(xTimeZ.y) % 20 < 15) {
-		gl_Position = projection * view * sphere(u, v, xTimeZ.y) * vec4(aPos, 1.0);
-		FragPos = vec3(sphere(u, v, xTimeZ.y) * vec4(aPos, 1.0));
-	} 
-	else if (int(xTimeZ.y) % 20 == 15) {
-		gl_Position = projection * view * mixMat4(sphere(u, v, xTimeZ.y), torus(u, v, xTimeZ.y), xTimeZ.y - floor(xTimeZ.y)) * vec4(aPos, 1.0);
-		FragPos = vec3(mixMat4(sphere(u, v, xTimeZ.y), torus(u, v, xTimeZ.y), xTimeZ.y - floor(xTimeZ.y)) * vec4(aPos, 1.0));
+	// an edge reaching behind the camera has no meaningful size on screen, it gets the finest split
+	return behind ? float(gl_MaxTessGenLevel) : clamp(level, 1.0, float(gl_MaxTessGenLevel));
+}
+
+void main() {
+	controlUV[gl_InvocationID] = cornerUV[gl_InvocationID];
+	// every invocation sizes one edge. Outer level i is the edge at u = 0, v = 0, u = 1 and v = 1 in turn,
+	// the one that ends at corner i
+	edgeLevels[gl_InvocationID] = edgeLevel(cornerUV[(gl_InvocationID + 3) % 4], cornerUV[gl_InvocationID]);
+	barrier();
+
+	// one invocation writes every level, llvmpipe loses the levels written by the others
+	if (gl_InvocationID == 0) {
+		for (int i = 0; i < 4; ++i) {
+			gl_TessLevelOuter[i] = edgeLevels[i];
+		}
+		// the inside is split at least as finely as the edges along it, and as the bend of its centre
+		// away from the corners asks for
+		vec3 centre = toScreen(mix(mix(cornerUV[0], cornerUV[1], 0.5), mix(cornerUV[3], cornerUV[2], 0.5), 0.5));
+		vec2 cornerAverage = 0.25 * (toScreen(cornerUV[0]).xy + toScreen(cornerUV[1]).xy + toScreen(cornerUV[2]).xy + toScreen(cornerUV[3]).xy);
+		float inside = centre.z <= 0.0 ? float(gl_MaxTessGenLevel) : clamp(curvatureLevel(distance(centre.xy, cornerAverage)), 1.0, float(gl_MaxTessGenLevel));
+		gl_TessLevelInner[0] = max(inside, max(edgeLevels[1], edgeLevels[3]));
+		gl_TessLevelInner[1] = max(inside, max(edgeLevels[0], edgeLevels[2]));
 	}
-	else if (int(xTimeZ.y) % 20 < 19) {
-		gl_Position = projection * view * torus(u, v, xTimeZ.y) * vec4(aPos, 1.0);
-		FragPos = vec3(torus(u, v, xTimeZ.y) * vec4(aPos, 1.0));
-	} 
-	else {
-		gl_Position = projection * view * mixMat4(torus(u, v, xTimeZ.y), wave(u, v, xTimeZ.y), xTimeZ.y - floor(xTimeZ.y)) * vec4(aPos, 1.0);
-		FragPos = vec3(mixMat4(torus(u, v, xTimeZ.y), wave(u, v, xTimeZ.y), xTimeZ.y - floor(xTimeZ.y)) * vec4(aPos, 1.0));
+}
+#elif defined(SHADER_STAGE_TESS_EVALUATION)
+layout (quads, fractional_odd_spacing, ccw) in;
+
+in vec2 controlUV[];
+
+void main() {
+	// the corners are in the order (0, 0), (1, 0), (1, 1), (0, 1) of the quad domain
+	vec2 uv = mix(mix(controlUV[0], controlUV[1], gl_TessCoord.x), mix(controlUV[3], controlUV[2], gl_TessCoord.x), gl_TessCoord.y);
+	vec4 worldPos = surface(uv.x, uv.y, time)[3];
+	TexCoords = (uv - tessDomain.xy) / (tessDomain.zw - tessDomain.xy);
+	gl_Position = viewProjection * worldPos;
+	FragPos = vec3(worldPos);
+}
+#else
+out vec2 cornerUV;
+
+void main() {
+	// the four corners of the patch in the order of the quad domain. Neighbouring patches compute their shared
+	// corners from the same whole numbers, so they match exactly
+	vec2 corner = vec2(gl_VertexID == 1 || gl_VertexID == 2, gl_VertexID >= 2);
+	vec2 patchPosition = vec2(int(patchIndex) % tessPatches, int(patchIndex) / tessPatches);
+	cornerUV = mix(tessDomain.xy, tessDomain.zw, (patchPosition + corner) / float(tessPatches));
+}
+#endif
+#else
+void main() {
+#ifdef SURFACE_LOD
+	// the vertex of the patch mesh in patch steps. Near the end of the patch's distance range the odd vertices
+	// slide onto their even neighbours, until the patch matches its parent's grid when the parent takes over
+	vec2 vertex = vec2(gl_VertexID % (patchQuads + 1), gl_VertexID / (patchQuads + 1));
+	vec2 uv = min(patchStartStep.xy + vertex * patchStartStep.z, lodEnd);
+	float cameraDistance = distance(cameraPosition.xyz, surface(uv.x, uv.y, time)[3].xyz);
+	float morph = clamp((cameraDistance - patchMorph.x) / (patchMorph.y - patchMorph.x), 0.0, 1.0);
+	vertex -= fract(vertex * 0.5) * 2.0 * morph;
+	uv = min(patchStartStep.xy + vertex * patchStartStep.z, lodEnd);
+
+	float u = uv.x;
+	float v = uv.y;
+	float t = time;
+#else
+#ifdef SURFACE_MESH
+	// one vertex per sample of the grid, the index buffer connects neighbouring samples into triangle strips.
+	// The chunks are drawn with their first sample as the base vertex, which gl_VertexID includes
+	int halfWidth = gridWidth / 2;
+	vec3 instance = vec3(gl_VertexID % gridWidth - halfWidth, time, gl_VertexID / gridWidth - halfWidth);
+#elif defined(SAMPLE_LIST)
+	// the CPU lists the sample of every instance, for the visible faces or the samples of the visible tiles
+	int halfWidth = gridWidth / 2;
+	int listed = int(sampleIndex) + firstSample;
+	vec3 instance = vec3(listed % gridWidth - halfWidth, time, listed / gridWidth - halfWidth);
+#else
+	int halfWidth = gridWidth / 2;
+#if defined(INSTANCE_SHORT2) || defined(INSTANCE_HALF2)
+	vec3 instance = vec3(instanceXZ.x, time, instanceXZ.y);
+#elif defined(INSTANCE_PACKED)
+	vec3 instance = vec3(int(instanceXZ & 0xFFFFu) - halfWidth, time, int(instanceXZ >> 16) - halfWidth);
+#else
+	vec3 instance = xTimeZ;
+#endif
+	if (proceduralInstances) {
+		int sampleID = gl_InstanceID + firstSample;
+		instance = vec3(sampleID % gridWidth - halfWidth, time, sampleID / gridWidth - halfWidth);
 	}
+#endif
+
+	float u = instance.x * gridStep;
+	float v = instance.z * gridStep;
+	float t = instance.y;
+#endif
+
+#ifdef SURFACE_LOD
+	vec4 worldPos = surface(u, v, t)[3];
+	TexCoords = vec2(u, v) / (gridWidth * gridStep) + 0.5;
+#elif defined(SURFACE_MESH)
+	// the sample itself is the translation of the cube transform
+	vec4 worldPos = surface(u, v, t)[3];
+	TexCoords = vec2(instance.x, instance.z) / gridWidth + 0.5;
+#else
+	vec4 worldPos = surface(u, v, t) * vec4(aPos, 1.0);
 	TexCoords = aTexCoords;
+#endif
+	gl_Position = viewProjection * worldPos;
+	FragPos = vec3(worldPos);
 }
+#endif
 
 )";
 #endif
\ No newline at end of file
@@ -0,0 +1,236 @@
+// Stress test for the job system. Runs many randomly sized loops and job
+// graphs and checks that every item of a loop runs exactly once in a block
+// aligned to the grains, that a job never starts before the jobs it depends
+// on have finished, that loops nested in jobs and jobs queued past
+// JOB_CAPACITY still finish, and that more threads than MAX_EXTERNAL_THREADS
+// can submit work at the same time. Prints the time of every part and exits
+// with an error on the first failed check.
+//
+// usage: jobsystem-stress [--threads <count>] [--rounds <count>] [--seed <value>]
+
+#include <surfaceEvaluator.h>
+#include <jobSystem.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+	using Clock = std::chrono::steady_clock;
+
+	// set by the first failed check, read by every part after it
+	std::atomic<bool> failed{};
+
+	void fail(const std::string& message) {
+		if (!failed.exchange(true)) {
+			std::cerr << "| ERROR::STRESS: " << message << '\n';
+		}
+	}
+
+	// one counter per item, the blocks of a loop count their items here
+	class Hits {
+	private:
+		std::unique_ptr<std::atomic<int>[]> m_counts{};
+		int m_size{};
+
+	public:
+		Hits(int size)
+			: m_counts{ new std::atomic<int>[static_cast<std::size_t>(size)]{} }
+			, m_size{ size }
+		{
+		}
+
+		void add(int item) { m_counts[item].fetch_add(1, std::memory_order_relaxed); }
+		// the first item not hit exactly once, -1 if there is none
+		int firstWrong() const {
+			for (int i{ 0 }; i < m_size; ++i) {
+				if (m_counts[i].load(std::memory_order_relaxed) != 1) {
+					return i;
+				}
+			}
+			return -1;
+		}
+	};
+
+	// a block of [begin, end) out of count items, checked against the grain
+	bool isValidBlock(int begin, int end, int count, int grain) {
+		return begin >= 0 && begin < end && end <= count && begin % grain == 0 && end - begin <= grain
+			&& (end - begin == grain || end == count);
+	}
+
+	void parallelFor(JobSystem& jobs, std::mt19937& random, int rounds) {
+		for (int round{ 0 }; round < rounds && !failed; ++round) {
+			int count{ std::uniform_int_distribution<int>{ 0, 200000 }(random) };
+			int grain{ 1 << std::uniform_int_distribution<int>{ 0, 12 }(random) };
+			Hits hits{ count };
+			jobs.parallelFor(count, grain, [&](int begin, int end) {
+				if (!isValidBlock(begin, end, count, grain)) {
+					fail("parallelFor block [" + std::to_string(begin) + ", " + std::to_string(end) + ") of " + std::to_string(count)
+						+ " items doesn't match the grain " + std::to_string(grain));
+					return;
+				}
+				for (int i{ begin }; i < end; ++i) {
+					hits.add(i);
+				}
+			});
+			if (int item{ hits.firstWrong() }; item >= 0) {
+				fail("parallelFor over " + std::to_string(count) + " items with grain " + std::to_string(grain)
+					+ " didn't run item " + std::to_string(item) + " exactly once");
+			}
+		}
+	}
+
+	void parallelFor2D(JobSystem& jobs, std::mt19937& random, int rounds) {
+		for (int round{ 0 }; round < rounds && !failed; ++round) {
+			int rows{ std::uniform_int_distribution<int>{ 0, 700 }(random) };
+			int columns{ std::uniform_int_distribution<int>{ 0, 700 }(random) };
+			int rowGrain{ std::uniform_int_distribution<int>{ 1, 64 }(random) };
+			int columnGrain{ std::uniform_int_distribution<int>{ 1, 256 }(random) };
+			Hits hits{ rows * columns };
+			jobs.parallelFor2D(rows, columns, rowGrain, columnGrain, [&](int rowBegin, int rowEnd, int columnBegin, int columnEnd) {
+				if (!isValidBlock(rowBegin, rowEnd, rows, rowGrain) || !isValidBlock(columnBegin, columnEnd, columns, columnGrain)) {
+					fail("parallelFor2D block doesn't match the grains " + std::to_string(rowGrain) + " x " + std::to_string(columnGrain));
+					return;
+				}
+				for (int row{ rowBegin }; row < rowEnd; ++row) {
+					for (int column{ columnBegin }; column < columnEnd; ++column) {
+						hits.add(row * columns + column);
+					}
+				}
+			});
+			if (int item{ hits.firstWrong() }; item >= 0) {
+				fail("parallelFor2D over " + std::to_string(rows) + " x " + std::to_string(columns) + " items didn't run row "
+					+ std::to_string(item / columns) + ", column " + std::to_string(item % columns) + " exactly once");
+			}
+		}
+	}
+
+	// loops started from the blocks of another loop, the waiting threads have to keep working on both
+	void nested(JobSystem& jobs, int rounds) {
+		const int OUTER{ 64 };
+		const int INNER{ 4096 };
+		for (int round{ 0 }; round < rounds && !failed; ++round) {
+			std::atomic<long long> sum{};
+			jobs.parallelFor(OUTER, 1, [&](int begin, int end) {
+				for (int outer{ begin }; outer < end; ++outer) {
+					jobs.parallelFor(INNER, 64, [&](int innerBegin, int innerEnd) {
+						long long part{};
+						for (int i{ innerBegin }; i < innerEnd; ++i) {
+							part += i;
+						}
+						sum.fetch_add(part, std::memory_order_relaxed);
+					});
+				}
+			});
+			long long expected{ static_cast<long long>(OUTER) * INNER * (INNER - 1) / 2 };
+			if (sum.load() != expected) {
+				fail("nested loops summed to " + std::to_string(sum.load()) + " instead of " + std::to_string(expected));
+			}
+		}
+	}
+
+	// stages of jobs where every stage depends on the counter of the one before. Some stages have more jobs
+	// than JOB_CAPACITY, which the submitting thread runs itself once its ring is full
+	void dependencies(JobSystem& jobs, std::mt19937& random, int rounds) {
+		const int STAGES{ 8 };
+		for (int round{ 0 }; round < rounds && !failed; ++round) {
+			JobSystem::Counter counters[STAGES]{};
+			std::atomic<int> finished[STAGES]{};
+			int sizes[STAGES]{};
+			for (int stage{ 0 }; stage < STAGES; ++stage) {
+				sizes[stage] = std::uniform_int_distribution<int>{ 1, 2 * JobSystem::JOB_CAPACITY }(random);
+				JobSystem::Counter* dependency{ stage > 0 ? &counters[stage - 1] : nullptr };
+				for (int i{ 0 }; i < sizes[stage]; ++i) {
+					jobs.run([stage, &finished, &sizes] {
+						if (stage > 0 && finished[stage - 1].load(std::memory_order_acquire) != sizes[stage - 1]) {
+							fail("a job of stage " + std::to_string(stage) + " started before stage " + std::to_string(stage - 1) + " had finished");
+						}
+						finished[stage].fetch_add(1, std::memory_order_acq_rel);
+					}, &counters[stage], dependency);
+				}
+			}
+			jobs.wait(counters[STAGES - 1]);
+			for (int stage{ 0 }; stage < STAGES; ++stage) {
+				if (!counters[stage].isDone() || finished[stage].load() != sizes[stage]) {
+					fail("stage " + std::to_string(stage) + " ran " + std::to_string(finished[stage].load()) + " of "
+						+ std::to_string(sizes[stage]) + " jobs");
+				}
+			}
+		}
+	}
+
+	// more threads than the system has deques for submit loops at once, the ones without a deque run theirs alone
+	void externalThreads(JobSystem& jobs, unsigned int seed, int rounds) {
+		std::vector<std::thread> threads{};
+		for (int t{ 0 }; t < JobSystem::MAX_EXTERNAL_THREADS + 4; ++t) {
+			threads.emplace_back([&jobs, seed, rounds, t] {
+				std::mt19937 random{ seed + static_cast<unsigned int>(t) + 1 };
+				parallelFor(jobs, random, rounds);
+				dependencies(jobs, random, rounds / 8 + 1);
+			});
+		}
+		for (std::thread& thread : threads) {
+			thread.join();
+		}
+	}
+
+	template <typename Function>
+	void timed(const char* name, Function function) {
+		if (failed) {
+			return;
+		}
+		auto start{ Clock::now() };
+		function();
+		double milliseconds{ std::chrono::duration<double, std::milli>(Clock::now() - start).count() };
+		std::cout << "| STRESS: " << std::left << std::setw(16) << name << std::right << std::setw(10) << milliseconds << " ms"
+			<< (failed ? ", failed" : "") << '\n';
+	}
+}
+
+int main(int argc, char* argv[]) {
+	if (!SurfaceEvaluator::isVectorUnitSupported()) {
+		std::cerr << "| ERROR::CPU: The library was built for " << SurfaceEvaluator::getVectorUnit()
+			<< ", which this CPU doesn't have. Build it without (xmake f --avx2=n)\n";
+		return -1;
+	}
+	unsigned int threads{ 0 };
+	int rounds{ 200 };
+	unsigned int seed{ std::random_device{}() };
+	for (int i{ 1 }; i + 1 < argc; i += 2) {
+		if (std::strcmp(argv[i], "--threads") == 0) {
+			threads = static_cast<unsigned int>(std::atoi(argv[i + 1]));
+		}
+		else if (std::strcmp(argv[i], "--rounds") == 0) {
+			rounds = std::atoi(argv[i + 1]);
+		}
+		else if (std::strcmp(argv[i], "--seed") == 0) {
+			seed = static_cast<unsigned int>(std::strtoul(argv[i + 1], nullptr, 10));
+		}
+	}
+
+	JobSystem jobs{ threads };
+	std::mt19937 random{ seed };
+	// the seed is printed so a failure can be run again
+	std::cout << "| STRESS: " << jobs.getThreadCount() << " threads, " << rounds << " rounds, seed " << seed << '\n'
+		<< std::fixed << std::setprecision(2);
+
+	timed("parallelFor", [&] { parallelFor(jobs, random, rounds); });
+	timed("parallelFor2D", [&] { parallelFor2D(jobs, random, rounds); });
+	timed("nested", [&] { nested(jobs, rounds / 4 + 1); });
+	timed("dependencies", [&] { dependencies(jobs, random, rounds / 4 + 1); });
+	timed("externalThreads", [&] { externalThreads(jobs, seed, rounds / 4 + 1); });
+
+	if (failed) {
+		return -1;
+	}
+	std::cout << "| STRESS: all checks passed\n";
+	return 0;
+}
\ No newline at end of file
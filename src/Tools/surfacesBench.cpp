@@ -0,0 +1,324 @@
+// Benchmarks the CPU surface evaluator against a plain scalar loop over the
+// same grid. Reports the throughput of the scalar loop and of the direct and
+// separable evaluation methods, and the largest deviation of each from the
+// formulas evaluated in double precision. Then runs the face culler from the
+// default camera position of the renderer and reports how many triangles of
+// the cube grid it removes per surface. Times the instance kernel of the
+// upload modes against a scalar loop and the streaming write bandwidth of
+// the machine, and the patch selection of the lod mode and the patch culling
+// of the tessellation mode from a few camera distances. Finally checks the interval bounds of
+// every surface and morph transition against dense sampling of random boxes
+// and reports their cost and how much larger than the sampled extent they are.
+//
+// usage: surfaces-bench [--width <samples per row>] [--threads <count>] [--iterations <count>]
+
+#include <surfaceEvaluator.h>
+#include <faceCuller.h>
+#include <instanceKernel.h>
+#include <gridChunks.h>
+#include <tileGrid.h>
+#include <lodQuadtree.h>
+#include <tessellationPatches.h>
+#include <morph.h>
+#include <surfaces.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+	using Clock = std::chrono::steady_clock;
+
+	// the surfaces of position.vert in double precision, the reference for the error figures
+	glm::dvec3 reference(Surfaces::Surface surface, double u, double v, double t) {
+		const double PI{ 3.14159265358979323846 };
+		switch (surface) {
+		case Surfaces::Surface::wave:
+			return { u, std::sin(PI * (u + v + t)), v };
+		case Surfaces::Surface::multiWave:
+			return { u, (std::sin(PI * (u + 0.5 * t)) + 0.5 * std::sin(2.0 * PI * (v + t)) + std::sin(PI * (u + v + 0.25 * t))) / 2.5, v };
+		case Surfaces::Surface::ripple: {
+			double d{ std::sqrt(u * u + v * v) };
+			return { u, std::sin(PI * (4.0 * d - t)) / (1.0 + 10.0 * d), v };
+		}
+		case Surfaces::Surface::sphere: {
+			double r{ 0.9 + 0.1 * std::sin(PI * (12.0 * u + 8.0 * v + t)) };
+			double s{ r * std::cos(0.5 * PI * v) };
+			return { s * std::sin(PI * u), r * std::sin(0.5 * PI * v), s * std::cos(PI * u) };
+		}
+		case Surfaces::Surface::torus: {
+			double r1{ 0.7 + 0.1 * std::sin(PI * (8.0 * u + 0.5 * t)) };
+			double r2{ 0.15 + 0.05 * std::sin(PI * (16.0 * u + 8.0 * v + 3.0 * t)) };
+			double s{ 0.5 + r1 + r2 * std::cos(PI * v) };
+			return { s * std::sin(PI * u), r2 * std::sin(PI * v), s * std::cos(PI * u) };
+		}
+		default:
+			return { u, 1.0, v };
+		}
+	}
+
+	template <typename Function>
+	double bestOf(int iterations, Function function) {
+		double best{ 1e30 };
+		for (int i{ 0 }; i < iterations; ++i) {
+			auto start{ Clock::now() };
+			function();
+			best = std::min(best, std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+		}
+		return best;
+	}
+
+	// memory aligned like a mapped buffer, which the instance kernel needs to stream its stores
+	constexpr std::align_val_t MAPPED_ALIGNMENT{ 64 };
+	struct AlignedDelete {
+		void operator()(unsigned char* memory) const { ::operator delete(memory, MAPPED_ALIGNMENT); }
+	};
+	using AlignedBytes = std::unique_ptr<unsigned char[], AlignedDelete>;
+
+	AlignedBytes allocateAligned(std::size_t bytes) {
+		return AlignedBytes{ static_cast<unsigned char*>(::operator new(bytes, MAPPED_ALIGNMENT)) };
+	}
+}
+
+int main(int argc, char* argv[]) {
+	if (!SurfaceEvaluator::isVectorUnitSupported()) {
+		std::cerr << "| ERROR::CPU: The surface evaluator was built for " << SurfaceEvaluator::getVectorUnit()
+			<< ", which this CPU doesn't have. Build it without (xmake f --avx2=n)\n";
+		return -1;
+	}
+	int width{ 1414 };
+	unsigned int threads{ 0 };
+	int iterations{ 5 };
+	for (int i{ 1 }; i + 1 < argc; i += 2) {
+		if (std::strcmp(argv[i], "--width") == 0) {
+			width = std::atoi(argv[i + 1]);
+		}
+		else if (std::strcmp(argv[i], "--threads") == 0) {
+			threads = static_cast<unsigned int>(std::atoi(argv[i + 1]));
+		}
+		else if (std::strcmp(argv[i], "--iterations") == 0) {
+			iterations = std::atoi(argv[i + 1]);
+		}
+	}
+
+	SurfaceGrid grid{ SurfaceGrid::instanceGrid(width) };
+	SurfaceEvaluator evaluator{ threads };
+	std::vector<glm::vec3> scalarPoints(grid.size());
+	std::vector<glm::vec3> points(grid.size());
+	std::vector<float> x(grid.size()), y(grid.size()), z(grid.size());
+	const float t{ 2.75f };
+	const double samples{ static_cast<double>(grid.size()) };
+
+	std::cout << "| BENCH: " << grid.columns << "x" << grid.rows << " samples, " << SurfaceEvaluator::getVectorUnit() << " ("
+		<< SurfaceEvaluator::getVectorWidth() << " lanes), " << evaluator.getThreadCount() << " threads\n"
+		<< std::fixed << std::setprecision(2);
+
+	for (int s{ 0 }; s < Surfaces::COUNT; ++s) {
+		Surfaces::Surface surface{ static_cast<Surfaces::Surface>(s) };
+
+		double scalar{ bestOf(iterations, [&] {
+			for (int row{ 0 }; row < grid.rows; ++row) {
+				for (int column{ 0 }; column < grid.columns; ++column) {
+					float u{ grid.uStart + static_cast<float>(column) * grid.uStep };
+					float v{ grid.vStart + static_cast<float>(row) * grid.vStep };
+					scalarPoints[row * grid.columns + column] = Surfaces::evaluate(surface, u, v, t);
+				}
+			}
+		}) };
+
+		// largest distance of the evaluator output from the double precision formulas
+		auto maxError{ [&] {
+			double error{ 0.0 };
+			for (int row{ 0 }; row < grid.rows; ++row) {
+				for (int column{ 0 }; column < grid.columns; ++column) {
+					int i{ row * grid.columns + column };
+					double u{ grid.uStart + static_cast<float>(column) * grid.uStep };
+					double v{ grid.vStart + static_cast<float>(row) * grid.vStep };
+					glm::dvec3 exact{ reference(surface, u, v, t) };
+					error = std::max({ error, glm::length(glm::dvec3{ x[i], y[i], z[i] } - exact), glm::length(glm::dvec3{ points[i] } - exact) });
+				}
+			}
+			return error;
+		} };
+
+		evaluator.setMethod(SurfaceEvaluator::Method::direct);
+		double direct{ bestOf(iterations, [&] { evaluator.evaluate(surface, grid, t, x.data(), y.data(), z.data()); }) };
+		evaluator.evaluate(surface, grid, t, points.data());
+		double directError{ maxError() };
+
+		evaluator.setMethod(SurfaceEvaluator::Method::separable);
+		double separable{ bestOf(iterations, [&] { evaluator.evaluate(surface, grid, t, x.data(), y.data(), z.data()); }) };
+		evaluator.evaluate(surface, grid, t, points.data());
+		double separableError{ maxError() };
+
+		std::cout << "| BENCH: " << std::setw(9) << Surfaces::name(surface)
+			<< " | scalar " << std::setw(7) << scalar << " ms (" << std::setw(7) << samples / scalar / 1e3 << " M/s)"
+			<< " | direct " << std::setw(6) << direct << " ms (" << std::setw(7) << samples / direct / 1e3 << " M/s)"
+			<< " | separable " << std::setw(6) << separable << " ms (" << std::setw(7) << samples / separable / 1e3 << " M/s, "
+			<< (SurfaceEvaluator::isSeparable(surface) ? "" : "not separable, ") << direct / separable << "x)"
+			<< std::scientific << std::setprecision(2)
+			<< " | max error direct " << directError << ", separable " << separableError
+			<< std::fixed << '\n';
+	}
+
+	// the camera main.cpp starts with
+	const glm::vec3 cameraPosition{ 0.0f, 0.0f, 3.0f };
+	FaceCuller culler{ FaceCuller::DEFAULT_TOLERANCE, threads };
+	std::vector<unsigned int> faceIndices(FaceCuller::maxIndices(grid));
+	FrameArena arena{};
+	arena.create(std::size_t{ 4 } << 20);
+	for (int s{ 0 }; s < Surfaces::COUNT; ++s) {
+		MorphState state{ static_cast<Surfaces::Surface>(s), static_cast<Surfaces::Surface>(s), 0.0f };
+		FaceCuller::FaceLists lists{};
+		double time{ bestOf(iterations, [&] {
+			arena.beginFrame();
+			lists = culler.update(state, grid, t, cameraPosition, faceIndices.data(), arena);
+		}) };
+
+		double faces{ static_cast<double>(grid.size()) * FaceCuller::FACE_COUNT };
+		std::cout << "| FACES: " << std::setw(9) << Surfaces::name(state.from)
+			<< " | update " << std::setw(6) << time << " ms"
+			<< " | " << std::setw(8) << 2 * lists.visible() << " of " << 2 * grid.size() * FaceCuller::FACE_COUNT << " triangles drawn"
+			<< " | removed " << std::setw(5) << 100.0 * (lists.backFacing + lists.covered) / faces << "% ("
+			<< std::setw(5) << 100.0 * lists.backFacing / faces << "% back-facing, "
+			<< std::setw(5) << 100.0 * lists.covered / faces << "% covered)\n";
+	}
+
+	// the lod mode's selection and the tessellation mode's culling at the renderer's projection, from the start position
+	// and closer and further away
+	const glm::mat4 projection{ glm::perspective(glm::radians(45.0f), 1600.0f / 900.0f, 0.1f, 1000.0f) };
+	const float pixelsPerUnit{ 0.5f * 900.0f * projection[1][1] };
+	LodQuadtree lodTree{ grid };
+	TessellationPatches tessellationPatches{ grid };
+	MorphState lodState{ Morph::at(t) };
+	for (float distance : { 1.5f, 3.0f, 6.0f, 12.0f }) {
+		glm::vec3 position{ 0.0f, 0.0f, distance };
+		glm::mat4 viewProjection{ projection * glm::lookAt(position, glm::vec3{ 0.0f }, glm::vec3{ 0.0f, 1.0f, 0.0f }) };
+		std::size_t patches{};
+		double time{ bestOf(iterations, [&] {
+			patches = lodTree.select(lodState, t, position, viewProjection, pixelsPerUnit).size();
+		}) };
+
+		std::cout << "| LOD: camera at " << std::setw(5) << distance
+			<< " | select " << std::setw(6) << time << " ms"
+			<< " | " << std::setw(4) << patches << " of " << lodTree.getMaxNodes() << " patches"
+			<< " | " << std::setw(6) << 100.0 * lodTree.getSelectedSamples() / grid.size() << "% of the grid's samples\n";
+
+		std::size_t visiblePatches{};
+		double cullTime{ bestOf(iterations, [&] {
+			visiblePatches = tessellationPatches.cull(lodState, t, viewProjection).size();
+		}) };
+		std::cout << "| TESSELLATION: camera at " << std::setw(5) << distance
+			<< " | cull " << std::setw(6) << cullTime << " ms"
+			<< " | " << std::setw(4) << visiblePatches << " of " << tessellationPatches.getPatchCount() << " patches\n";
+	}
+
+	// the instance formats of the upload modes at the renderer's grid and at 16M instances, the kernel writes into
+	// memory aligned like a mapped buffer so it streams. The stream mode writes the chunks of the grid one by one
+	InstanceKernel instanceKernel{ evaluator.getJobs() };
+	for (int instanceWidth : { width, 4000 }) {
+		const std::size_t instanceCount{ static_cast<std::size_t>(instanceWidth) * instanceWidth };
+		GridChunks instanceChunks{ SurfaceGrid::instanceGrid(instanceWidth), TileGrid::DEFAULT_TILE_SIZE };
+		AlignedBytes scalarInstances{ allocateAligned(instanceCount * sizeof(glm::vec3)) };
+		AlignedBytes instances{ allocateAligned(instanceCount * sizeof(glm::vec3)) };
+		double bandwidth{ instanceKernel.measureWriteBandwidth(instanceCount * sizeof(glm::vec3)) };
+		std::cout << "| INSTANCES: " << instanceWidth << "x" << instanceWidth << " (" << instanceCount / 1000000.0 << "M) instances"
+			<< " in " << instanceChunks.getCount() << (instanceChunks.getCount() == 1 ? " chunk" : " chunks") << " | streaming writes " << bandwidth / 1e9 << " GB/s\n";
+
+		for (InstanceKernel::Format format : { InstanceKernel::Format::float3, InstanceKernel::Format::short2,
+			InstanceKernel::Format::half2, InstanceKernel::Format::packed }) {
+			double scalarTime{ bestOf(iterations, [&] { InstanceKernel::generateScalar(instanceWidth, t, format, scalarInstances.get()); }) };
+			double kernelTime{ bestOf(iterations, [&] { instanceKernel.generate(instanceWidth, t, format, instances.get()); }) };
+			const std::size_t bytes{ instanceCount * InstanceKernel::instanceSize(format) };
+			bool matches{ std::memcmp(scalarInstances.get(), instances.get(), bytes) == 0 };
+
+			std::memset(instances.get(), 0, bytes);
+			for (const GridChunks::Chunk& chunk : instanceChunks.getChunks()) {
+				unsigned char* output{ instances.get() + chunk.firstSample * InstanceKernel::instanceSize(format) };
+				instanceKernel.generate(instanceWidth, t, format, output, chunk.firstSample, chunk.grid.size());
+			}
+			bool chunksMatch{ std::memcmp(scalarInstances.get(), instances.get(), bytes) == 0 };
+			std::cout << "| INSTANCES: " << std::setw(6) << InstanceKernel::formatName(format)
+				<< " | " << std::setw(7) << bytes / (1024.0 * 1024.0) << " MB"
+				<< " | scalar " << std::setw(7) << scalarTime << " ms"
+				<< " | kernel " << std::setw(6) << kernelTime << " ms (" << std::setw(5) << bytes / kernelTime / 1e6 << " GB/s, "
+				<< std::setw(5) << 100.0 * bytes / kernelTime * 1e3 / bandwidth << "% of streaming writes)"
+				<< " | " << (matches ? "matches the scalar loop" : "differs from the scalar loop")
+				<< (chunksMatch ? ", in chunks too" : ", differs in chunks") << '\n';
+		}
+	}
+
+	// boxes the size of a 64 x 64 tile over a tenth of a second, every state of the morph cycle
+	std::mt19937 random{ 1 };
+	std::uniform_real_distribution<float> coordinate{ -1.0f, 1.0f };
+	const float boxSize{ 64.0f * grid.uStep };
+	const int boxes{ 2000 };
+	const int steps{ 12 };
+	for (float cycleTime{ 1.5f }; cycleTime < Morph::CYCLE; cycleTime += 2.0f) {
+		MorphState state{ Morph::at(cycleTime) };
+		std::vector<Interval> us(boxes), vs(boxes), ts(boxes);
+		for (int b{ 0 }; b < boxes; ++b) {
+			float u{ coordinate(random) };
+			float v{ coordinate(random) };
+			float time{ cycleTime + 0.1f * coordinate(random) };
+			us[b] = Interval{ u, u + boxSize };
+			vs[b] = Interval{ v, v + boxSize };
+			ts[b] = Interval{ time, time + 0.1f };
+		}
+
+		std::vector<Surfaces::Bounds> bounds(boxes);
+		double time{ bestOf(iterations, [&] {
+			for (int b{ 0 }; b < boxes; ++b) {
+				bounds[b] = Morph::bounds(state, us[b], vs[b], ts[b]);
+			}
+		}) };
+
+		// sample every box on a grid including its corners, no sample may leave the bounds
+		int violations{ 0 };
+		double boundsSize{ 0.0 };
+		double sampledSize{ 0.0 };
+		for (int b{ 0 }; b < boxes; ++b) {
+			glm::vec3 low{ 1e30f };
+			glm::vec3 high{ -1e30f };
+			for (int i{ 0 }; i <= steps; ++i) {
+				for (int j{ 0 }; j <= steps; ++j) {
+					for (int k{ 0 }; k <= 2; ++k) {
+						float u{ us[b].lo + us[b].width() * i / steps };
+						float v{ vs[b].lo + vs[b].width() * j / steps };
+						float time{ ts[b].lo + ts[b].width() * k / 2 };
+						glm::vec3 point{ Morph::evaluate(state, u, v, time) };
+						low = glm::min(low, point);
+						high = glm::max(high, point);
+						violations += glm::any(glm::lessThan(point, bounds[b].min)) || glm::any(glm::greaterThan(point, bounds[b].max));
+					}
+				}
+			}
+			glm::vec3 boundsExtent{ bounds[b].max - bounds[b].min };
+			glm::vec3 sampledExtent{ high - low };
+			boundsSize += boundsExtent.x + boundsExtent.y + boundsExtent.z;
+			sampledSize += sampledExtent.x + sampledExtent.y + sampledExtent.z;
+		}
+
+		std::string name{ Surfaces::name(state.from) };
+		if (state.isTransition()) {
+			name += std::string{ " -> " } + Surfaces::name(state.to);
+		}
+		std::cout << "| BOUNDS: " << std::setw(19) << name
+			<< " | " << std::setw(5) << 1000.0 * time / boxes << " us per box"
+			<< " | " << std::setw(4) << boundsSize / sampledSize << "x the sampled extent"
+			<< " | " << violations << " samples outside\n";
+	}
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,105 @@
+#include <allocationCheck.h>
+
+#ifdef ENABLE_ALLOCATION_CHECK
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+namespace {
+	// the innermost armed scope of the thread, nullptr while allocating is fine
+	thread_local const char* armedScope{};
+
+	void check(std::size_t size) {
+		if (armedScope != nullptr) {
+			const char* where{ armedScope };
+			armedScope = nullptr;
+			// no iostream, it may allocate itself
+			std::fprintf(stderr, "| ERROR::ALLOCATION: %zu bytes allocated on the heap in \"%s\" after warm-up\n", size, where);
+			std::abort();
+		}
+	}
+
+	void* allocate(std::size_t size) {
+		check(size);
+		void* memory{ std::malloc(size != 0 ? size : 1) };
+		if (memory == nullptr) {
+			throw std::bad_alloc{};
+		}
+		return memory;
+	}
+
+	void* allocateAligned(std::size_t size, std::align_val_t alignment) {
+		check(size);
+		std::size_t align{ static_cast<std::size_t>(alignment) };
+#ifdef _WIN32
+		void* memory{ _aligned_malloc(size != 0 ? size : 1, align) };
+#else
+		// aligned_alloc needs the size to be a multiple of the alignment
+		void* memory{ std::aligned_alloc(align, (std::max<std::size_t>(size, 1) + align - 1) / align * align) };
+#endif
+		if (memory == nullptr) {
+			throw std::bad_alloc{};
+		}
+		return memory;
+	}
+
+	void freeAligned(void* memory) {
+#ifdef _WIN32
+		_aligned_free(memory);
+#else
+		std::free(memory);
+#endif
+	}
+}
+
+namespace AllocationCheck {
+	Scope::Scope(const char* where, bool armed)
+		: m_previous{ armedScope }
+	{
+		if (armed) {
+			armedScope = where;
+		}
+	}
+
+	Scope::~Scope() {
+		armedScope = m_previous;
+	}
+}
+
+void* operator new(std::size_t size) { return allocate(size); }
+void* operator new[](std::size_t size) { return allocate(size); }
+void* operator new(std::size_t size, std::align_val_t alignment) { return allocateAligned(size, alignment); }
+void* operator new[](std::size_t size, std::align_val_t alignment) { return allocateAligned(size, alignment); }
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+	try {
+		return allocate(size);
+	}
+	catch (const std::bad_alloc&) {
+		return nullptr;
+	}
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+	try {
+		return allocate(size);
+	}
+	catch (const std::bad_alloc&) {
+		return nullptr;
+	}
+}
+
+void operator delete(void* memory) noexcept { std::free(memory); }
+void operator delete[](void* memory) noexcept { std::free(memory); }
+void operator delete(void* memory, std::size_t) noexcept { std::free(memory); }
+void operator delete[](void* memory, std::size_t) noexcept { std::free(memory); }
+void operator delete(void* memory, std::align_val_t) noexcept { freeAligned(memory); }
+void operator delete[](void* memory, std::align_val_t) noexcept { freeAligned(memory); }
+void operator delete(void* memory, std::size_t, std::align_val_t) noexcept { freeAligned(memory); }
+void operator delete[](void* memory, std::size_t, std::align_val_t) noexcept { freeAligned(memory); }
+#endif
\ No newline at end of file
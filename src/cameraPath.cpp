@@ -0,0 +1,102 @@
+#include <cameraPath.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace {
+	// cubic Hermite segment from p1 to p2 at s in [0, 1], with the tangents per second and h the length of the segment in seconds
+	template <typename T>
+	T hermite(const T& p1, const T& m1, const T& p2, const T& m2, float h, float s) {
+		float s2{ s * s };
+		float s3{ s2 * s };
+		return (2.0f * s3 - 3.0f * s2 + 1.0f) * p1 + (s3 - 2.0f * s2 + s) * h * m1
+			+ (-2.0f * s3 + 3.0f * s2) * p2 + (s3 - s2) * h * m2;
+	}
+
+	glm::vec2 angles(const CameraPath::Keyframe& keyframe) {
+		return glm::vec2{ keyframe.yaw, keyframe.pitch };
+	}
+}
+
+bool CameraPath::load(const std::string& path) {
+	std::ifstream file{ path };
+	if (!file) {
+		std::cerr << "| ERROR::CAMERA_PATH: Failed to open " << path << '\n';
+		return false;
+	}
+
+	std::vector<Keyframe> keyframes{};
+	std::string line{};
+	int lineNumber{ 0 };
+	while (std::getline(file, line)) {
+		++lineNumber;
+		std::size_t first{ line.find_first_not_of(" \t\r") };
+		if (first == std::string::npos || line[first] == '#') {
+			continue;
+		}
+
+		std::istringstream stream{ line };
+		Keyframe keyframe{};
+		stream >> keyframe.time >> keyframe.position.x >> keyframe.position.y >> keyframe.position.z >> keyframe.yaw >> keyframe.pitch;
+		if (!stream) {
+			std::cerr << "| ERROR::CAMERA_PATH: " << path << ':' << lineNumber << ": expected time x y z yaw pitch\n";
+			return false;
+		}
+		if (!keyframes.empty() && keyframe.time <= keyframes.back().time) {
+			std::cerr << "| ERROR::CAMERA_PATH: " << path << ':' << lineNumber << ": keyframe times have to increase\n";
+			return false;
+		}
+		keyframes.push_back(keyframe);
+	}
+
+	if (keyframes.empty()) {
+		std::cerr << "| ERROR::CAMERA_PATH: " << path << " has no keyframes\n";
+		return false;
+	}
+	m_keyframes = std::move(keyframes);
+	return true;
+}
+
+CameraPath::Keyframe CameraPath::at(float time) const {
+	if (m_keyframes.empty()) {
+		return Keyframe{ time };
+	}
+	if (time <= m_keyframes.front().time) {
+		return m_keyframes.front();
+	}
+	if (time >= m_keyframes.back().time) {
+		return m_keyframes.back();
+	}
+
+	// the segment from keyframe i to i + 1 that contains the time
+	auto next{ std::upper_bound(m_keyframes.begin(), m_keyframes.end(), time,
+		[](float time, const Keyframe& keyframe) { return time < keyframe.time; }) };
+	std::size_t i{ static_cast<std::size_t>(next - m_keyframes.begin()) - 1 };
+	const Keyframe& k1{ m_keyframes[i] };
+	const Keyframe& k2{ m_keyframes[i + 1] };
+	// the end keyframes stand in for their missing neighbours
+	const Keyframe& k0{ m_keyframes[i > 0 ? i - 1 : i] };
+	const Keyframe& k3{ m_keyframes[i + 2 < m_keyframes.size() ? i + 2 : i + 1] };
+
+	// Catmull-Rom tangents, divided by the time between the neighbours so keyframes at uneven intervals still give a smooth velocity
+	float h{ k2.time - k1.time };
+	float s{ (time - k1.time) / h };
+	glm::vec3 positionTangent1{ (k2.position - k0.position) / (k2.time - k0.time) };
+	glm::vec3 positionTangent2{ (k3.position - k1.position) / (k3.time - k1.time) };
+	glm::vec2 angleTangent1{ (angles(k2) - angles(k0)) / (k2.time - k0.time) };
+	glm::vec2 angleTangent2{ (angles(k3) - angles(k1)) / (k3.time - k1.time) };
+
+	glm::vec3 position{ hermite(k1.position, positionTangent1, k2.position, positionTangent2, h, s) };
+	glm::vec2 angle{ hermite(angles(k1), angleTangent1, angles(k2), angleTangent2, h, s) };
+	return Keyframe{ time, position, angle.x, angle.y };
+}
+
+float CameraPath::getDuration() const {
+	return m_keyframes.empty() ? 0.0f : m_keyframes.back().time;
+}
+
+int CameraPath::getKeyframeCount() const {
+	return static_cast<int>(m_keyframes.size());
+}
\ No newline at end of file
@@ -0,0 +1,48 @@
+#include <frameStats.h>
+
+#include <algorithm>
+#include <iostream>
+
+void FrameStats::addFrame(double frameTime) {
+	for (Accumulator* accumulator : { &m_interval, &m_total }) {
+		++accumulator->frames;
+		accumulator->frameTime += frameTime;
+		accumulator->frameTimeMax = std::max(accumulator->frameTimeMax, frameTime);
+	}
+}
+
+void FrameStats::addUpload(double uploadTime, bool stalled) {
+	for (Accumulator* accumulator : { &m_interval, &m_total }) {
+		accumulator->uploadTime += uploadTime;
+		accumulator->uploadTimeMax = std::max(accumulator->uploadTimeMax, uploadTime);
+		accumulator->uploadStalls += stalled ? 1 : 0;
+	}
+}
+
+void FrameStats::report(double currentTime) {
+	if (m_intervalStart < 0.0) {
+		m_intervalStart = currentTime;
+	}
+	if (currentTime - m_intervalStart < m_reportInterval || m_interval.frames == 0) {
+		return;
+	}
+	m_print("STATS", m_interval);
+	m_interval = Accumulator{};
+	m_intervalStart = currentTime;
+}
+
+void FrameStats::printSummary() {
+	if (m_total.frames > 0) {
+		m_print("SUMMARY", m_total);
+	}
+}
+
+void FrameStats::m_print(const char* label, const Accumulator& accumulator) {
+	double frames{ static_cast<double>(accumulator.frames) };
+	double averageFrame{ accumulator.frameTime / frames };
+	std::cout << "| " << label << ": " << accumulator.frames << " frames"
+		<< " | frame avg " << averageFrame * 1000.0 << " ms, max " << accumulator.frameTimeMax * 1000.0 << " ms ("
+		<< (averageFrame > 0.0 ? 1.0 / averageFrame : 0.0) << " fps)"
+		<< " | upload avg " << accumulator.uploadTime / frames * 1000.0 << " ms, max " << accumulator.uploadTimeMax * 1000.0 << " ms"
+		<< " | upload stalls " << accumulator.uploadStalls << '\n';
+}
\ No newline at end of file
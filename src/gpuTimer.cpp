@@ -0,0 +1,60 @@
+#include <gpuTimer.h>
+
+#include <glad/glad.h>
+
+#include <algorithm>
+
+void GpuTimer::create() {
+	glGenQueries(QUERIES, m_queries);
+}
+
+void GpuTimer::destroy() {
+	if (m_queries[0] == 0) {
+		return;
+	}
+	for (int i{ 0 }; i < QUERIES; ++i) {
+		m_collect(i);
+	}
+	glDeleteQueries(QUERIES, m_queries);
+	for (unsigned int& query : m_queries) {
+		query = 0;
+	}
+}
+
+void GpuTimer::begin() {
+	// the query being reused was issued QUERIES frames ago
+	m_collect(m_next);
+	glBeginQuery(GL_TIME_ELAPSED, m_queries[m_next]);
+}
+
+void GpuTimer::end() {
+	glEndQuery(GL_TIME_ELAPSED);
+	m_issued[m_next] = true;
+	m_next = (m_next + 1) % QUERIES;
+}
+
+unsigned long long GpuTimer::getCount() {
+	return m_count;
+}
+
+double GpuTimer::getAverage() {
+	return m_count > 0 ? m_total / static_cast<double>(m_count) : 0.0;
+}
+
+double GpuTimer::getMax() {
+	return m_max;
+}
+
+void GpuTimer::m_collect(int query) {
+	if (!m_issued[query]) {
+		return;
+	}
+	GLuint64 elapsed{};
+	glGetQueryObjectui64v(m_queries[query], GL_QUERY_RESULT, &elapsed);
+	m_issued[query] = false;
+
+	double seconds{ static_cast<double>(elapsed) * 1e-9 };
+	++m_count;
+	m_total += seconds;
+	m_max = std::max(m_max, seconds);
+}
\ No newline at end of file
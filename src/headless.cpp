@@ -0,0 +1,116 @@
+#include <headless.h>
+
+#include <glad/glad.h>
+
+#ifdef HAS_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+#include <iostream>
+
+#ifdef HAS_EGL
+bool HeadlessContext::create(int width, int height) {
+	// prefer the surfaceless platform, it needs neither a display server nor a GPU device
+	EGLDisplay display{ EGL_NO_DISPLAY };
+	auto getPlatformDisplay{ reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT")) };
+	if (getPlatformDisplay != nullptr) {
+		display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+	}
+	if (display == EGL_NO_DISPLAY) {
+		display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+	}
+
+	EGLint major{};
+	EGLint minor{};
+	if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor)) {
+		std::cerr << "| ERROR::HEADLESS: Failed to initialise an EGL display\n";
+		return false;
+	}
+	if (!eglBindAPI(EGL_OPENGL_API)) {
+		std::cerr << "| ERROR::HEADLESS: EGL " << major << '.' << minor << " does not support desktop OpenGL\n";
+		eglTerminate(display);
+		return false;
+	}
+
+	// same version and profile as the window, no config since nothing is presented
+	const EGLint contextAttributes[]{
+		EGL_CONTEXT_MAJOR_VERSION, 3,
+		EGL_CONTEXT_MINOR_VERSION, 3,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+		EGL_NONE,
+	};
+	EGLContext context{ eglCreateContext(display, EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, contextAttributes) };
+	if (context == EGL_NO_CONTEXT || !eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)) {
+		std::cerr << "| ERROR::HEADLESS: Failed to create an OpenGL 3.3 core context (EGL error 0x" << std::hex << eglGetError() << std::dec << ")\n";
+		eglTerminate(display);
+		return false;
+	}
+	m_display = display;
+	m_context = context;
+
+	if (!gladLoadGLLoader((GLADloadproc)eglGetProcAddress)) {
+		std::cerr << "| ERROR::HEADLESS: Failed to initialise GLAD\n";
+		destroy();
+		return false;
+	}
+
+	// the framebuffer stands in for the window
+	glGenFramebuffers(1, &m_framebuffer);
+	glGenRenderbuffers(2, m_renderbuffers);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, m_renderbuffers[0]);
+	glRenderbufferStorageMultisample(GL_RENDERBUFFER, SAMPLES, GL_RGBA8, width, height);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_renderbuffers[0]);
+	glBindRenderbuffer(GL_RENDERBUFFER, m_renderbuffers[1]);
+	glRenderbufferStorageMultisample(GL_RENDERBUFFER, SAMPLES, GL_DEPTH_COMPONENT24, width, height);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_renderbuffers[1]);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+		std::cerr << "| ERROR::HEADLESS: Framebuffer is incomplete\n";
+		destroy();
+		return false;
+	}
+	glViewport(0, 0, width, height);
+
+	std::cout << "| HEADLESS: " << glGetString(GL_RENDERER) << ", OpenGL " << glGetString(GL_VERSION) << '\n';
+	m_start = std::chrono::steady_clock::now();
+	return true;
+}
+
+void HeadlessContext::destroy() {
+	if (m_context == nullptr) {
+		return;
+	}
+	if (m_framebuffer != 0) {
+		glDeleteFramebuffers(1, &m_framebuffer);
+		glDeleteRenderbuffers(2, m_renderbuffers);
+		m_framebuffer = 0;
+	}
+	eglMakeCurrent(m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+	eglDestroyContext(m_display, m_context);
+	eglTerminate(m_display);
+	m_context = nullptr;
+	m_display = nullptr;
+}
+#else
+bool HeadlessContext::create(int, int) {
+	std::cerr << "| ERROR::HEADLESS: This build has no EGL support\n";
+	return false;
+}
+
+void HeadlessContext::destroy() {
+}
+#endif
+
+void HeadlessContext::finishFrame() {
+	glFinish();
+}
+
+double HeadlessContext::getTime() {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start).count();
+}
+
+bool HeadlessContext::isActive() {
+	return m_context != nullptr;
+}
\ No newline at end of file
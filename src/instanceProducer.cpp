@@ -0,0 +1,145 @@
+#include <instanceProducer.h>
+#include <trace.h>
+#include <allocationCheck.h>
+
+#include <algorithm>
+#include <iostream>
+#include <new>
+
+InstanceProducer::InstanceProducer(int gridWidth, InstanceKernel::Format format, JobSystem& jobs)
+	: m_gridWidth{ gridWidth }
+	, m_format{ format }
+	, m_kernel{ jobs }
+{
+}
+
+InstanceProducer::~InstanceProducer() {
+	stop();
+}
+
+bool InstanceProducer::create() {
+	const std::size_t bytes{ static_cast<std::size_t>(m_gridWidth) * m_gridWidth * InstanceKernel::instanceSize(m_format) };
+	if (m_frames.getBack().instances.size() == bytes) {
+		return true;
+	}
+	try {
+		m_frames.forEachSlot([bytes](Frame& frame) { frame.instances.resize(bytes); });
+	}
+	catch (const std::bad_alloc&) {
+		m_frames.forEachSlot([](Frame& frame) { frame.instances = std::vector<unsigned char>{}; });
+		std::cerr << "| ERROR::PRODUCER: Can't allocate 3 x " << static_cast<double>(bytes) / (1024.0 * 1024.0) << " MB for the instances of a "
+			<< m_gridWidth << " x " << m_gridWidth << " grid, use a smaller grid or a compact instance format\n";
+		return false;
+	}
+	return true;
+}
+
+void InstanceProducer::start(float time) {
+	m_fill(m_frames.getBack(), time);
+	m_frames.publish();
+	m_published.fetch_add(1, std::memory_order_release);
+
+	m_stop.store(false, std::memory_order_relaxed);
+	m_requestedTime.store(time, std::memory_order_relaxed);
+	m_thread = std::thread{ &InstanceProducer::m_run, this };
+}
+
+void InstanceProducer::stop() {
+	if (!m_thread.joinable()) {
+		return;
+	}
+	m_stop.store(true, std::memory_order_relaxed);
+	m_requests.fetch_add(1, std::memory_order_release);
+	m_requests.notify_one();
+	m_thread.join();
+}
+
+void InstanceProducer::request(float time) {
+	m_requestedTime.store(time, std::memory_order_relaxed);
+	m_requests.fetch_add(1, std::memory_order_release);
+	m_requests.notify_one();
+}
+
+const InstanceProducer::Frame& InstanceProducer::acquire() {
+	// nothing new means the producer hasn't finished the requested frame and the last one is drawn again
+	m_repeated += m_frames.update() ? 0 : 1;
+	return m_take(m_frames.getFront());
+}
+
+const InstanceProducer::Frame& InstanceProducer::acquire(float time) {
+	bool waited{ false };
+	for (;;) {
+		// read before looking at the frames, so a frame published in between wakes the wait below
+		unsigned int published{ m_published.load(std::memory_order_acquire) };
+		m_frames.update();
+		if (m_frames.getFront().time == time) {
+			break;
+		}
+		// after a mode switch the producer may still be on an older request
+		if (m_requestedTime.load(std::memory_order_relaxed) != time) {
+			request(time);
+		}
+		TRACE_ZONE("wait for instances");
+		waited = true;
+		m_published.wait(published, std::memory_order_acquire);
+	}
+	m_waited += waited ? 1 : 0;
+	return m_take(m_frames.getFront());
+}
+
+const InstanceProducer::Frame& InstanceProducer::m_take(const Frame& frame) {
+	double latency{ std::chrono::duration<double>(std::chrono::steady_clock::now() - frame.published).count() };
+	++m_acquired;
+	m_latency += latency;
+	m_latencyMax = std::max(m_latencyMax, latency);
+	return frame;
+}
+
+void InstanceProducer::printSummary() {
+	if (m_acquired == 0) {
+		return;
+	}
+	double averageBuild{ m_produceTime / static_cast<double>(std::max(m_produced, 1ull)) };
+	std::cout << "| PRODUCER: " << m_produced << " frames built | build avg " << averageBuild * 1000.0 << " ms, max "
+		<< m_produceTimeMax * 1000.0 << " ms (up to " << (averageBuild > 0.0 ? 1.0 / averageBuild : 0.0) << " frames/s)"
+		<< " | " << m_acquired << " frames drawn, " << m_repeated << " repeated, " << m_waited << " waited for | latency avg "
+		<< m_latency / static_cast<double>(m_acquired) * 1000.0 << " ms, max " << m_latencyMax * 1000.0 << " ms\n";
+}
+
+bool InstanceProducer::isRunning() {
+	return m_thread.joinable();
+}
+
+void InstanceProducer::m_run() {
+	unsigned int seen{ 0 };
+	for (;;) {
+		// sleeps until a request comes in that hasn't been built yet
+		m_requests.wait(seen, std::memory_order_acquire);
+		seen = m_requests.load(std::memory_order_acquire);
+		if (m_stop.load(std::memory_order_relaxed)) {
+			break;
+		}
+
+		TRACE_ZONE("produce instances");
+		// the frames were allocated up front, once the job system has registered this thread building one allocates nothing
+		CHECK_NO_ALLOCATIONS("instance producer", m_produced >= AllocationCheck::WARMUP_FRAMES);
+		auto start{ std::chrono::steady_clock::now() };
+		Frame& frame{ m_frames.getBack() };
+		m_fill(frame, m_requestedTime.load(std::memory_order_relaxed));
+		frame.published = std::chrono::steady_clock::now();
+		m_frames.publish();
+		m_published.fetch_add(1, std::memory_order_release);
+		m_published.notify_one();
+
+		double produceTime{ std::chrono::duration<double>(frame.published - start).count() };
+		++m_produced;
+		m_produceTime += produceTime;
+		m_produceTimeMax = std::max(m_produceTimeMax, produceTime);
+	}
+}
+
+void InstanceProducer::m_fill(Frame& frame, float time) {
+	m_kernel.generate(m_gridWidth, time, m_format, frame.instances.data());
+	frame.time = time;
+	frame.published = std::chrono::steady_clock::now();
+}
\ No newline at end of file
@@ -6,72 +6,334 @@
 #include <glm/gtc/type_ptr.hpp>
 
 #include <shader.h>
+#include <rendererPrograms.h>
+#include <morph.h>
 #include <camera.h>
 #include <shapes.h>
 #include <globals.h>
+#include <streamBuffer.h>
+#include <frameStats.h>
+#include <faceCuller.h>
+#include <tileGrid.h>
+#include <options.h>
+#include <headless.h>
+#include <cameraPath.h>
+#include <replayStats.h>
+#include <trace.h>
+#include <frameUniforms.h>
+#include <instanceProducer.h>
+#include <instanceKernel.h>
+#include <surfaceEvaluator.h>
+#include <gridChunks.h>
+#include <lodQuadtree.h>
+#include <tessellationPatches.h>
+#include <gpuTimer.h>
+#include <frameArena.h>
+#include <allocationCheck.h>
 
 #define CPP_SHADER_INCLUDE
 #include <position.vert>
 #include <position.frag>
 
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
 #include <iostream>
+#include <vector>
 
 // camera
 Camera camera{ glm::vec3{0.0f, 0.0f, 3.0f} };
 
 unsigned int cubeVAO{};
-unsigned int instanceVBO{};
+unsigned int meshVAO{};
+unsigned int lodVAO{};
+// the nodes the quadtree selected this frame, one patch instance each
+StreamBuffer lodNodeBuffer{};
+unsigned int tessellationVAO{};
+// the indices of the visible coarse patches of the tessellation mode
+StreamBuffer tessellationPatchBuffer{};
+constexpr unsigned int MESH_RESTART_INDEX{ 0xFFFFFFFF };
+// the buffers that grow with the grid, one set per chunk of rows (see gridChunks.h)
+struct ChunkBuffers {
+    StreamBuffer instances{};
+    StreamBuffer faces{};
+    // the samples of the chunk in tile order
+    unsigned int tileSamples{};
+};
+std::vector<ChunkBuffers> chunkBuffers{};
+// GPU time of the instanced cube draws, what fetching the instance attribute costs in each format
+GpuTimer instanceDrawTimer{};
+StreamBuffer frameUniformBuffer{};
+
+// how the visible tiles are submitted, the best the context supports
+enum class TileSubmission {
+    multiDrawIndirect,  // one glMultiDrawElementsIndirect for every tile
+    baseInstance,       // one glDrawElementsInstancedBaseInstance per run of tiles
+    attributeOffset,    // OpenGL 3.3: the sample attribute is moved to every run of tiles
+};
+
+// layout of a command in GL_DRAW_INDIRECT_BUFFER
+struct DrawElementsIndirectCommand {
+    unsigned int count;
+    unsigned int instanceCount;
+    unsigned int firstIndex;
+    int baseVertex;
+    unsigned int baseInstance;
+};
+
+StreamBuffer tileCommandBuffer{};
+TileSubmission tileSubmission{ TileSubmission::attributeOffset };
+
+// stands in for the window when rendering without a display
+HeadlessContext headless{};
 
 void frameBufferSizeCallback(GLFWwindow* window, int width, int height);
 void processInput(GLFWwindow* window);
 void mouseCallback(GLFWwindow*, double xPos, double yPos);
+void keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods);
+void createCubeVAO();
 void renderCube(int instanceAmount);
-
-int main() {
-    glfwInit();
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-    glfwWindowHint(GLFW_SAMPLES, 4);
-
-    GLFWwindow* window{ glfwCreateWindow(GLOBALS::SCR_WIDTH, GLOBALS::SCR_HEIGHT, "Mathematical Surfaces", nullptr, nullptr) };
-    if (window == nullptr) {
-        std::cerr << "Failed to create GLFW window\n";
-        glfwTerminate();
+void renderInstances(StreamBuffer& buffer, std::size_t bufferOffset, int instanceAmount, InstanceKernel::Format format);
+void renderInstanceChunks(GridChunks& chunks, const std::size_t* bufferOffsets, InstanceKernel::Format format);
+void renderCubeFaces(StreamBuffer& buffer, const FaceCuller::FaceLists& lists, std::size_t bufferOffset);
+void createTileBuffers(TileGrid& tiles, GridChunks& chunks);
+void renderTiles(const std::vector<TileGrid::Range>& ranges, GridChunks& chunks);
+void createMeshVAO(int gridWidth, GridChunks& chunks);
+void renderMesh(GridChunks& chunks);
+void createLodVAO(int maxNodes);
+void renderLod(std::size_t bufferOffset, int nodeCount);
+void createTessellationVAO(int patchCount);
+void renderTessellation(std::size_t bufferOffset, int patchCount);
+double getTime();
+
+int main(int argc, char* argv[]) {
+    // before anything runs the evaluator
+    if (!SurfaceEvaluator::isVectorUnitSupported()) {
+        std::cerr << "| ERROR::CPU: The surface evaluator was built for " << SurfaceEvaluator::getVectorUnit()
+            << ", which this CPU doesn't have. Build it without (xmake f --avx2=n)\n";
         return -1;
     }
-    glfwMakeContextCurrent(window);
-    glfwSetFramebufferSizeCallback(window, frameBufferSizeCallback);
-    glfwSetCursorPosCallback(window, mouseCallback);
+    Options options{};
+    if (!parseOptions(argc, argv, options)) {
+        return -1;
+    }
+    GLOBALS::renderMode = options.renderMode;
+
+    // a replay flies a scripted path on a fixed timestep, so every run renders the same frames
+    bool replay{ !options.replayPath.empty() };
+    CameraPath cameraPath{};
+    if (replay) {
+        if (!cameraPath.load(options.replayPath)) {
+            return -1;
+        }
+        if (options.frames == 0) {
+            float duration{ std::max(cameraPath.getDuration(), Morph::CYCLE) };
+            options.frames = static_cast<int>(std::ceil(duration / options.timestep)) + 1;
+        }
+    }
+    ReplayStats replayStats{};
+    replayStats.reserve(options.frames);
+
+    GLFWwindow* window{ nullptr };
+    if (options.headless) {
+        // no window and no input, the loop renders into an offscreen framebuffer
+        if (!headless.create(GLOBALS::SCR_WIDTH, GLOBALS::SCR_HEIGHT)) {
+            return -1;
+        }
+    }
+    else {
+        glfwInit();
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+        glfwWindowHint(GLFW_SAMPLES, 4);
+
+        window = glfwCreateWindow(GLOBALS::SCR_WIDTH, GLOBALS::SCR_HEIGHT, "Mathematical Surfaces", nullptr, nullptr);
+        if (window == nullptr) {
+            std::cerr << "Failed to create GLFW window\n";
+            glfwTerminate();
+            return -1;
+        }
+        glfwMakeContextCurrent(window);
+        glfwSetFramebufferSizeCallback(window, frameBufferSizeCallback);
+        glfwSetCursorPosCallback(window, mouseCallback);
+        glfwSetKeyCallback(window, keyCallback);
 
-    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+        glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
 
-    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
-        std::cerr << "Failed to initialise GLAD\n";
-        return -1;
+        if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+            std::cerr << "Failed to initialise GLAD\n";
+            return -1;
+        }
     }
 
     glEnable(GL_DEPTH_TEST);
     glEnable(GL_CULL_FACE);
 
+    // build and compile shaders, one program per state of the morph cycle for the cubes and for the mesh.
+    // Programs linked on an earlier launch come from the binary cache, the others compile while the buffers are set up
+    double compileStart{ getTime() };
+    ProgramBinaryCache binaryCache{};
+    if (!options.shaderCachePath.empty()) {
+        binaryCache.open(options.shaderCachePath);
+    }
+    ShaderCompiler shaderCompiler{};
+    RendererPrograms programs{};
+    const InstanceKernel::Format instanceFormat{ options.instanceFormat };
+    const int gridWidth{ options.gridWidth };
+    if (gridWidth > InstanceKernel::maxGridWidth(instanceFormat)) {
+        std::cerr << "| ERROR::OPTIONS: The " << InstanceKernel::formatName(instanceFormat) << " instance format can't address a grid "
+            << gridWidth << " wide, at most " << InstanceKernel::maxGridWidth(instanceFormat) << '\n';
+        return -1;
+    }
+    if (GLOBALS::renderMode == RenderMode::tessellation && !GLAD_GL_ARB_tessellation_shader) {
+        std::cerr << "| ERROR::OPTIONS: The tessellation mode needs ARB_tessellation_shader, which this context doesn't have\n";
+        return -1;
+    }
+    programs.setInstanceDefines(InstanceKernel::shaderDefines(instanceFormat));
+    if (options.shaderDirectory.empty()) {
+        programs.submit(shaderCompiler, positionVert, positionFrag, &binaryCache);
+    }
+    else if (!programs.submitFromDirectory(shaderCompiler, options.shaderDirectory, &binaryCache)) {
+        return -1;
+    }
+
     // instance stuff
-    constexpr int amount{ 1999396 };
-    glm::vec3* instanceData{ new glm::vec3[amount]{} };
+    const int amount{ gridWidth * gridWidth };
+    // CPU work of the frame: the face culler and the instance producer, one thread per core between them
+    JobSystem jobs{};
+    // the instances are built on their own thread while this one uploads and draws the previous frame. The producer
+    // holds three grids of instances, so it is only set up once the upload mode is drawn
+    InstanceProducer instanceProducer{ gridWidth, instanceFormat, jobs };
+    // the stream mode builds the instances on this thread's jobs instead
+    InstanceKernel instanceKernel{ jobs };
+    const std::size_t instanceSize{ InstanceKernel::instanceSize(instanceFormat) };
+    const std::size_t instanceBytes{ amount * instanceSize };
+    instanceDrawTimer.create();
+
+    // the grid in chunks of rows that end on tile borders, every buffer that grows with the grid is one per chunk
+    SurfaceGrid grid{ SurfaceGrid::instanceGrid(gridWidth) };
+    GridChunks chunks{ grid, TileGrid::DEFAULT_TILE_SIZE, options.chunkSamples };
+    chunkBuffers.resize(chunks.getCount());
+    for (int c{ 0 }; c < chunks.getCount(); ++c) {
+        const SurfaceGrid& chunkGrid{ chunks.getChunks()[c].grid };
+        // three frames in flight: the CPU writes one region while the GPU reads the other two
+        chunkBuffers[c].instances.create(GL_ARRAY_BUFFER, chunkGrid.size() * instanceSize, 3);
+        // the sample index of every visible face, filled by the face culler
+        chunkBuffers[c].faces.create(GL_ARRAY_BUFFER, FaceCuller::maxIndices(chunkGrid) * sizeof(unsigned int), 3);
+    }
+    std::cout << "| GRID: " << gridWidth << " x " << gridWidth << " samples in " << chunks.getCount() << (chunks.getCount() == 1 ? " chunk" : " chunks")
+        << " of up to " << chunks.getRowsPerChunk() << " rows, " << static_cast<double>(chunks.getMaxSamples()) * instanceSize / (1024.0 * 1024.0)
+        << " MB of instances each\n";
+
+    FaceCuller faceCuller{ jobs };
+    // scratch memory of the frame, the face culler's chunk offsets and the offsets of the instance chunks
+    FrameArena frameArena{};
+    if (!frameArena.create(std::size_t{ 4 } << 20)) {
+        return -1;
+    }
+
+    // the instance grid in tiles for frustum culling
+    TileGrid tiles{ grid };
+    createTileBuffers(tiles, chunks);
+
+    // the grid in patches whose density follows the camera distance
+    LodQuadtree lodTree{ grid, LodQuadtree::DEFAULT_MAX_NODES, options.lodPixelError };
+    // the grid in coarse patches the GPU tessellates
+    TessellationPatches tessellationPatches{ grid };
+
+    // the per-frame uniform block, written once per frame for every program
+    frameUniformBuffer.create(GL_UNIFORM_BUFFER, sizeof(FrameUniforms), 3);
 
-    // build and compile shaders
-    Shader shader{};
-    shader.compile(positionVert, positionFrag);
+    FrameStats frameStats{};
+
+    // the instance attribute is attached to the cube VAO, so it has to exist before the first frame
+    createCubeVAO();
+    createMeshVAO(gridWidth, chunks);
+    createLodVAO(lodTree.getMaxNodes());
+    if (GLAD_GL_ARB_tessellation_shader) {
+        createTessellationVAO(tessellationPatches.getPatchCount());
+    }
+
+    // the programs were submitted before the buffers were set up, wait for the ones still compiling
+    shaderCompiler.waitAll();
+    std::cout << "| SHADERS: " << shaderCompiler.getFinishedCount() << " programs ready after " << (getTime() - compileStart) * 1000.0 << " ms"
+        << (shaderCompiler.isParallel() ? ", compiled in parallel\n" : "\n");
+    binaryCache.printSummary();
+
+    std::cout << "| MODE: " << renderModeName(GLOBALS::renderMode) << (options.headless ? "\n" : " (press M to switch)\n");
+    if (replay) {
+        std::cout << "| REPLAY: " << options.replayPath << ", " << cameraPath.getKeyframeCount() << " keyframes, "
+            << options.frames << " frames of " << options.timestep * 1000.0f << " ms\n";
+    }
+    if (!options.tracePath.empty() && !Trace::start()) {
+        return -1;
+    }
 
-    // configure shaders
+    if (GLOBALS::renderMode == RenderMode::instanceUpload && !instanceProducer.create()) {
+        return -1;
+    }
 
     // render loop
-    while (!glfwWindowShouldClose(window)) {
-        float currentFrame = static_cast<float>(glfwGetTime());
+    int frame{ 0 };
+    // frames rendered with the current program, the allocation check starts after a few of them
+    int steadyFrames{ 0 };
+    const Shader* steadyProgram{ nullptr };
+    RenderMode steadyMode{ GLOBALS::renderMode };
+    // time the streamed instances took, reported against the write bandwidth of the machine
+    double streamTime{ 0.0 };
+    int streamFrames{ 0 };
+    while (options.frames == 0 || frame < options.frames) {
+        if (window != nullptr && glfwWindowShouldClose(window)) {
+            break;
+        }
+        TRACE_ZONE("frame");
+        double frameStart{ getTime() };
+        float currentFrame = replay ? static_cast<float>(frame) * options.timestep : static_cast<float>(frameStart);
         GLOBALS::deltaTime = currentFrame - GLOBALS::lastFrame;
         GLOBALS::lastFrame = currentFrame;
+        ++frame;
+        frameArena.beginFrame();
 
         // input
-        processInput(window);
+        if (replay) {
+            CameraPath::Keyframe pose{ cameraPath.at(currentFrame) };
+            camera.setPose(pose.position, pose.yaw, pose.pitch);
+        }
+        else if (window != nullptr) {
+            processInput(window);
+        }
+
+        // changed shader files are rebuilt in the background, a rebuilt set only replaces the old one here between frames
+        programs.update();
+
+        // the morph state only changes once per frame, so the matching program is picked here instead of per vertex
+        MorphState morph{ Morph::at(currentFrame) };
+        if (GLOBALS::renderMode == RenderMode::instanceUpload && !instanceProducer.isRunning()) {
+            if (instanceProducer.create()) {
+                instanceProducer.start(currentFrame);
+            }
+            else {
+                // switched to at runtime, create() said why
+                GLOBALS::renderMode = nextRenderMode(GLOBALS::renderMode);
+            }
+        }
+        bool mesh{ GLOBALS::renderMode == RenderMode::mesh };
+        bool lod{ GLOBALS::renderMode == RenderMode::lod };
+        bool tessellation{ GLOBALS::renderMode == RenderMode::tessellation };
+        bool visibleFaces{ GLOBALS::renderMode == RenderMode::visibleFaces };
+        bool tileCulling{ GLOBALS::renderMode == RenderMode::tiles };
+        ProgramCache& cache{ tessellation ? programs.getTessellation() : (lod ? programs.getLod()
+            : (mesh ? programs.getMesh() : (visibleFaces || tileCulling ? programs.getSampleList() : programs.getCubes()))) };
+        Shader& shader{ cache.get(morph) };
+
+        // a new mode or surface gets a few frames to size its buffers, and the driver may finish compiling a program
+        // on its first draws. From then on the frame must not allocate
+        steadyFrames = &shader == steadyProgram && GLOBALS::renderMode == steadyMode ? steadyFrames + 1 : 0;
+        steadyProgram = &shader;
+        steadyMode = GLOBALS::renderMode;
+        CHECK_NO_ALLOCATIONS("render loop", steadyFrames >= AllocationCheck::WARMUP_FRAMES);
 
         // projection and view matrices
         glm::mat4 projection{ glm::perspective(glm::radians(camera.getZoom()),
@@ -83,45 +345,254 @@ int main() {
 
         // render
         // -------------------------------------------------
+        FrameUniforms frameUniforms{ view, projection, projection * view, glm::vec4{ camera.getPosition(), 1.0f }, currentFrame,
+            morph.blend, morph.weight(), gridWidth, static_cast<int>(morph.from), static_cast<int>(morph.to), grid.uStep, grid.cubeSize() };
+        std::memcpy(frameUniformBuffer.map(), &frameUniforms, sizeof(FrameUniforms));
+        std::size_t frameUniformOffset{ frameUniformBuffer.unmap() };
+        glBindBufferRange(GL_UNIFORM_BUFFER, FrameUniforms::BINDING, frameUniformBuffer.getId(), frameUniformOffset, sizeof(FrameUniforms));
+
         shader.use();
-        shader.setMatrix4("projection", projection);
-        shader.setMatrix4("view", view);
-
-        int index = 0;
-        for (int z = -707; z < 707; ++z) {
-            for (int x = -707; x < 707; ++x) {
-                instanceData[index] = glm::vec3{ x, currentFrame, z };
-                ++index;
+
+        bool procedural{ GLOBALS::renderMode == RenderMode::procedural };
+        shader.setInteger("proceduralInstances", procedural);
+
+        if (mesh) {
+            // the surface is seen from both sides and the strips alternate their winding
+            glDisable(GL_CULL_FACE);
+            renderMesh(chunks);
+            glEnable(GL_CULL_FACE);
+        }
+        else if (lod) {
+            // the selection and its upload take the place of the instance upload
+            double selectStart{ getTime() };
+            std::size_t nodeOffset{};
+            int nodeCount{};
+            {
+                TRACE_ZONE("select lod");
+                float pixelsPerUnit{ 0.5f * static_cast<float>(GLOBALS::SCR_HEIGHT) * projection[1][1] };
+                const std::vector<LodQuadtree::Node>& nodes{ lodTree.select(morph, currentFrame, camera.getPosition(),
+                    frameUniforms.viewProjection, pixelsPerUnit) };
+                std::memcpy(lodNodeBuffer.map(), nodes.data(), nodes.size() * sizeof(LodQuadtree::Node));
+                nodeOffset = lodNodeBuffer.unmap();
+                nodeCount = static_cast<int>(nodes.size());
             }
+            frameStats.addUpload(getTime() - selectStart, lodNodeBuffer.lastMapStalled());
+
+            shader.setVector2f("lodEnd", lodTree.getEnd());
+            shader.setInteger("patchQuads", LodQuadtree::PATCH_QUADS);
+            // seen from both sides like the mesh
+            glDisable(GL_CULL_FACE);
+            renderLod(nodeOffset, nodeCount);
+            glEnable(GL_CULL_FACE);
         }
+        else if (tessellation) {
+            // only the visible coarse patches are uploaded, the GPU refines them
+            double cullStart{ getTime() };
+            std::size_t patchOffset{};
+            int patchCount{};
+            {
+                TRACE_ZONE("cull patches");
+                const std::vector<unsigned int>& patches{ tessellationPatches.cull(morph, currentFrame, frameUniforms.viewProjection) };
+                std::memcpy(tessellationPatchBuffer.map(), patches.data(), patches.size() * sizeof(unsigned int));
+                patchOffset = tessellationPatchBuffer.unmap();
+                patchCount = static_cast<int>(patches.size());
+            }
+            frameStats.addUpload(getTime() - cullStart, tessellationPatchBuffer.lastMapStalled());
+
+            shader.setInteger("tessPatches", tessellationPatches.getPatches());
+            shader.setVector4f("tessDomain", tessellationPatches.getDomain());
+            shader.setFloat("tessPixelError", options.tessellationPixelError);
+            shader.setFloat("tessEdgePixels", TessellationPatches::MAX_EDGE_PIXELS);
+            shader.setVector2f("viewportSize", static_cast<float>(GLOBALS::SCR_WIDTH), static_cast<float>(GLOBALS::SCR_HEIGHT));
+            // seen from both sides like the mesh
+            glDisable(GL_CULL_FACE);
+            renderTessellation(patchOffset, patchCount);
+            glEnable(GL_CULL_FACE);
+        }
+        else if (visibleFaces) {
+            // every chunk is culled into its own buffer and drawn while the next one is culled
+            double cullTime{ 0.0 };
+            bool stalled{ false };
+            for (int c{ 0 }; c < chunks.getCount(); ++c) {
+                const GridChunks::Chunk& chunk{ chunks.getChunks()[c] };
+                StreamBuffer& faceBuffer{ chunkBuffers[c].faces };
+                double cullStart{ getTime() };
+                FaceCuller::FaceLists lists{};
+                std::size_t faceOffset{};
+                {
+                    TRACE_ZONE("cull faces");
+                    lists = faceCuller.update(morph, chunk.grid, currentFrame, camera.getPosition(), static_cast<unsigned int*>(faceBuffer.map()),
+                        frameArena);
+                    faceOffset = faceBuffer.unmap();
+                }
+                cullTime += getTime() - cullStart;
+                stalled = stalled || faceBuffer.lastMapStalled();
+
+                shader.setInteger("firstSample", chunk.firstSample);
+                renderCubeFaces(faceBuffer, lists, faceOffset);
+                faceBuffer.fence();
+            }
+            frameStats.addUpload(cullTime, stalled);
+        }
+        else if (tileCulling) {
+            const std::vector<TileGrid::Range>* ranges{};
+            {
+                TRACE_ZONE("cull tiles");
+                ranges = &tiles.cull(morph, currentFrame, frameUniforms.viewProjection);
+            }
+            // the tile order lists the samples of the whole grid
+            shader.setInteger("firstSample", 0);
+            renderTiles(*ranges, chunks);
+        }
+        else if (procedural) {
+            // grid coordinates and time come from gl_InstanceID and the time uniform, nothing to upload
+            glBindVertexArray(cubeVAO);
+            glDisableVertexAttribArray(3);
+
+            for (const GridChunks::Chunk& chunk : chunks.getChunks()) {
+                shader.setInteger("firstSample", chunk.firstSample);
+                renderCube(chunk.grid.size());
+            }
+        }
+        else if (GLOBALS::renderMode == RenderMode::instanceStream) {
+            // built on every thread straight into the mapped regions, nothing is staged or copied
+            double uploadStart{ getTime() };
+            std::size_t* instanceOffsets{ frameArena.allocate<std::size_t>(chunks.getCount()) };
+            bool stalled{ false };
+            {
+                TRACE_ZONE("stream instances");
+                for (int c{ 0 }; c < chunks.getCount(); ++c) {
+                    const GridChunks::Chunk& chunk{ chunks.getChunks()[c] };
+                    StreamBuffer& instanceBuffer{ chunkBuffers[c].instances };
+                    instanceKernel.generate(gridWidth, currentFrame, instanceFormat, instanceBuffer.map(), chunk.firstSample, chunk.grid.size());
+                    instanceOffsets[c] = instanceBuffer.unmap();
+                    stalled = stalled || instanceBuffer.lastMapStalled();
+                }
+            }
+            double uploadTime{ getTime() - uploadStart };
+            frameStats.addUpload(uploadTime, stalled);
+            streamTime += uploadTime;
+            ++streamFrames;
 
-        glGenBuffers(1, &instanceVBO);
-        glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
-        glBufferData(GL_ARRAY_BUFFER, amount * sizeof(glm::vec3), &instanceData[0], GL_STATIC_DRAW);
-
-        glBindVertexArray(cubeVAO);
-        glEnableVertexAttribArray(3);
-        glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
-        glVertexAttribDivisor(3, 1);
+            renderInstanceChunks(chunks, instanceOffsets, instanceFormat);
+        }
+        else {
+            // the newest frame the producer has finished, then it starts on the next one while this one is drawn.
+            // A replay draws every frame at its own time, so it waits if the producer is behind
+            const InstanceProducer::Frame& instances{ replay ? instanceProducer.acquire(currentFrame) : instanceProducer.acquire() };
+            instanceProducer.request(replay ? static_cast<float>(frame) * options.timestep : currentFrame + GLOBALS::deltaTime);
+
+            double uploadStart{ getTime() };
+            std::size_t* instanceOffsets{ frameArena.allocate<std::size_t>(chunks.getCount()) };
+            bool stalled{ false };
+            {
+                TRACE_ZONE("upload instances");
+                for (int c{ 0 }; c < chunks.getCount(); ++c) {
+                    const GridChunks::Chunk& chunk{ chunks.getChunks()[c] };
+                    StreamBuffer& instanceBuffer{ chunkBuffers[c].instances };
+                    std::memcpy(instanceBuffer.map(), instances.instances.data() + chunk.firstSample * instanceSize, chunk.grid.size() * instanceSize);
+                    instanceOffsets[c] = instanceBuffer.unmap();
+                    stalled = stalled || instanceBuffer.lastMapStalled();
+                }
+            }
+            frameStats.addUpload(getTime() - uploadStart, stalled);
 
-        renderCube(amount);
+            renderInstanceChunks(chunks, instanceOffsets, instanceFormat);
+        }
 
         glBindVertexArray(0);
+        frameUniformBuffer.fence();
 
-        glfwSwapBuffers(window);
-        glfwPollEvents();
-        glDeleteBuffers(1, &instanceVBO);
+        if (window != nullptr) {
+            {
+                TRACE_ZONE("swap buffers");
+                glfwSwapBuffers(window);
+            }
+            glfwPollEvents();
+        }
+        else {
+            TRACE_ZONE("finish frame");
+            headless.finishFrame();
+        }
+        Trace::endFrame();
+
+        double frameTime{ getTime() - frameStart };
+        frameStats.addFrame(frameTime);
+        frameStats.report(frameStart);
+        if (replay) {
+            replayStats.addFrame(morph, frameTime);
+        }
+    }
+    instanceProducer.stop();
+    frameStats.printSummary();
+    instanceProducer.printSummary();
+    replayStats.printSummary();
+    if (Trace::isEnabled()) {
+        Trace::stop(options.tracePath);
+    }
+    faceCuller.printSummary();
+    frameArena.printSummary();
+    // reads the queries of the last frames
+    instanceDrawTimer.destroy();
+    if (instanceDrawTimer.getCount() > 0) {
+        std::cout << "| INSTANCES: " << InstanceKernel::formatName(instanceFormat) << ", " << InstanceKernel::instanceSize(instanceFormat)
+            << " bytes per instance, " << instanceBytes / (1024.0 * 1024.0) << " MB per frame"
+            << " | draw avg " << instanceDrawTimer.getAverage() * 1000.0 << " ms, max " << instanceDrawTimer.getMax() * 1000.0 << " ms on the GPU\n";
+    }
+    if (streamFrames > 0) {
+        double achieved{ static_cast<double>(instanceBytes) * streamFrames / streamTime };
+        double bandwidth{ instanceKernel.measureWriteBandwidth(instanceBytes) };
+        std::cout << "| INSTANCES: " << streamFrames << " frames streamed at " << streamTime / streamFrames * 1000.0 << " ms per frame, "
+            << achieved / 1e9 << " GB/s, " << 100.0 * achieved / bandwidth << "% of the " << bandwidth / 1e9
+            << " GB/s this machine writes with streaming stores\n";
+    }
+    tiles.printSummary();
+    lodTree.printSummary();
+    tessellationPatches.printSummary();
+    std::cout << "| UNIFORMS: " << programs.getSkippedUploads() << " redundant uploads skipped\n";
+    if (!options.shaderDirectory.empty()) {
+        std::cout << "| SHADER_RELOAD: " << programs.getReloadCount() << " reloads, " << programs.getFailedReloadCount() << " failed\n";
+    }
+    unsigned int stalls{ 0 };
+    unsigned int orphans{ 0 };
+    for (ChunkBuffers& buffers : chunkBuffers) {
+        stalls += buffers.instances.getStallCount();
+        orphans += buffers.instances.getOrphanCount();
+    }
+    std::cout << "| STREAM: " << (chunkBuffers.front().instances.isPersistent() ? "persistent mapping" : "orphaning fallback")
+        << ", " << stalls << " stalls, " << orphans << " orphans\n";
+
+    programs.destroy();
+    for (ChunkBuffers& buffers : chunkBuffers) {
+        buffers.instances.destroy();
+        buffers.faces.destroy();
+        glDeleteBuffers(1, &buffers.tileSamples);
+    }
+    frameUniformBuffer.destroy();
+    tileCommandBuffer.destroy();
+    lodNodeBuffer.destroy();
+    if (GLAD_GL_ARB_tessellation_shader) {
+        tessellationPatchBuffer.destroy();
+    }
+    if (window != nullptr) {
+        glfwTerminate();
+    }
+    else {
+        headless.destroy();
     }
-    delete[] instanceData;
-    glfwTerminate();
     return 0;
 }
 
+double getTime() {
+    return headless.isActive() ? headless.getTime() : glfwGetTime();
+}
+
 void frameBufferSizeCallback(GLFWwindow*, int width, int height) {
     glViewport(0, 0, width, height);
 }
 
 void processInput(GLFWwindow* window) {
+    TRACE_ZONE("process input");
     glfwSetCursorPosCallback(window, mouseCallback);
 
     if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
@@ -152,6 +623,16 @@ void processInput(GLFWwindow* window) {
     }
 }
 
+void keyCallback(GLFWwindow*, int key, int, int action, int) {
+    if (key == GLFW_KEY_M && action == GLFW_PRESS) {
+        GLOBALS::renderMode = nextRenderMode(GLOBALS::renderMode);
+        if (GLOBALS::renderMode == RenderMode::tessellation && !GLAD_GL_ARB_tessellation_shader) {
+            GLOBALS::renderMode = nextRenderMode(GLOBALS::renderMode);
+        }
+        std::cout << "| MODE: " << renderModeName(GLOBALS::renderMode) << '\n';
+    }
+}
+
 void mouseCallback(GLFWwindow*, double xPos, double yPos) {
     float xPosF{ static_cast<float>(xPos) };
     float yPosF{ static_cast<float>(yPos) };
@@ -173,31 +654,356 @@ void mouseCallback(GLFWwindow*, double xPos, double yPos) {
 unsigned int cubeVBO{ 0 };
 unsigned int cubeEBO{ 0 };
 
-void renderCube(int instanceAmount) {
+void createCubeVAO() {
+    glGenVertexArrays(1, &cubeVAO);
+    glGenBuffers(1, &cubeVBO);
+    glGenBuffers(1, &cubeEBO);
 
-    if (cubeVAO == 0) {
-        glGenVertexArrays(1, &cubeVAO);
-        glGenBuffers(1, &cubeVBO);
-        glGenBuffers(1, &cubeEBO);
+    glBindBuffer(GL_ARRAY_BUFFER, cubeVBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(Shapes::cube), &Shapes::cube, GL_STATIC_DRAW);
 
-        glBindBuffer(GL_ARRAY_BUFFER, cubeVBO);
-        glBufferData(GL_ARRAY_BUFFER, sizeof(Shapes::cube), &Shapes::cube, GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, cubeEBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(Shapes::cubeIndices), Shapes::cubeIndices, GL_STATIC_DRAW);
 
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, cubeEBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(Shapes::cubeIndices), Shapes::cubeIndices, GL_STATIC_DRAW);
+    glBindVertexArray(cubeVAO);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+}
 
-        glBindVertexArray(cubeVAO);
-        glEnableVertexAttribArray(0);
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-        glEnableVertexAttribArray(1);
-        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-        glBindVertexArray(0);
+void renderCube(int instanceAmount) {
+    TRACE_GPU_ZONE("render cubes");
+    if (cubeVAO == 0) {
+        createCubeVAO();
     }
 
     glBindVertexArray(cubeVAO);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, cubeEBO);
     glDrawElementsInstanced(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0, instanceAmount);
     glBindVertexArray(0);
+}
+
+void renderInstances(StreamBuffer& buffer, std::size_t bufferOffset, int instanceAmount, InstanceKernel::Format format) {
+    // one instance per cube from the instance buffer region written this frame, read the way position.vert expects the format
+    glBindVertexArray(cubeVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, buffer.getId());
+    glEnableVertexAttribArray(3);
+    GLsizei stride{ static_cast<GLsizei>(InstanceKernel::instanceSize(format)) };
+    switch (format) {
+    case InstanceKernel::Format::short2:
+        glVertexAttribIPointer(3, 2, GL_SHORT, stride, (void*)bufferOffset);
+        break;
+    case InstanceKernel::Format::half2:
+        glVertexAttribPointer(3, 2, GL_HALF_FLOAT, GL_FALSE, stride, (void*)bufferOffset);
+        break;
+    case InstanceKernel::Format::packed:
+        glVertexAttribIPointer(3, 1, GL_UNSIGNED_INT, stride, (void*)bufferOffset);
+        break;
+    default:
+        glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, stride, (void*)bufferOffset);
+        break;
+    }
+    glVertexAttribDivisor(3, 1);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    renderCube(instanceAmount);
+    buffer.fence();
+}
+
+void renderInstanceChunks(GridChunks& chunks, const std::size_t* bufferOffsets, InstanceKernel::Format format) {
+    // the instances carry their grid coordinates, so the chunks are drawn back to back under one timer query
+    instanceDrawTimer.begin();
+    for (int c{ 0 }; c < chunks.getCount(); ++c) {
+        renderInstances(chunkBuffers[c].instances, bufferOffsets[c], chunks.getChunks()[c].grid.size(), format);
+    }
+    instanceDrawTimer.end();
+}
+
+void renderCubeFaces(StreamBuffer& buffer, const FaceCuller::FaceLists& lists, std::size_t bufferOffset) {
+    TRACE_GPU_ZONE("render faces");
+    glBindVertexArray(cubeVAO);
+    glDisableVertexAttribArray(3);
+    glBindBuffer(GL_ARRAY_BUFFER, buffer.getId());
+    glEnableVertexAttribArray(4);
+    glVertexAttribDivisor(4, 1);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, cubeEBO);
+
+    // the six indices of every face are consecutive in Shapes::cubeIndices, in the order of FaceCuller::Face
+    for (int face{ 0 }; face < FaceCuller::FACE_COUNT; ++face) {
+        if (lists.counts[face] == 0) {
+            continue;
+        }
+        std::size_t listOffset{ bufferOffset + lists.offsets[face] * sizeof(unsigned int) };
+        glVertexAttribIPointer(4, 1, GL_UNSIGNED_INT, sizeof(unsigned int), (void*)listOffset);
+        glDrawElementsInstanced(GL_TRIANGLES, 6, GL_UNSIGNED_INT, (void*)(face * 6 * sizeof(unsigned int)), lists.counts[face]);
+    }
+
+    glDisableVertexAttribArray(4);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+}
+
+void createTileBuffers(TileGrid& tiles, GridChunks& chunks) {
+    // the samples never change order, so the lists the tiles index into are uploaded once. The chunks end on
+    // tile borders, so the samples of a chunk are one run of the tile order starting at its first sample
+    for (int c{ 0 }; c < chunks.getCount(); ++c) {
+        const GridChunks::Chunk& chunk{ chunks.getChunks()[c] };
+        std::vector<unsigned int> samples{ tiles.sampleOrder(chunk.firstSample, chunk.grid.size()) };
+        glGenBuffers(1, &chunkBuffers[c].tileSamples);
+        glBindBuffer(GL_ARRAY_BUFFER, chunkBuffers[c].tileSamples);
+        glBufferData(GL_ARRAY_BUFFER, samples.size() * sizeof(unsigned int), samples.data(), GL_STATIC_DRAW);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    if (GLAD_GL_ARB_multi_draw_indirect && GLAD_GL_ARB_draw_indirect && GLAD_GL_ARB_base_instance) {
+        tileSubmission = TileSubmission::multiDrawIndirect;
+        // a run of tiles across a chunk border is split in two
+        std::size_t commands{ static_cast<std::size_t>(tiles.getTileCount() + chunks.getCount()) };
+        tileCommandBuffer.create(GL_DRAW_INDIRECT_BUFFER, commands * sizeof(DrawElementsIndirectCommand), 3);
+    }
+    else if (GLAD_GL_ARB_base_instance) {
+        tileSubmission = TileSubmission::baseInstance;
+    }
+
+    const char* names[]{ "multi-draw indirect", "base instance", "attribute offsets" };
+    std::cout << "| TILES: " << tiles.getTileCount() << " tiles, submitted with " << names[static_cast<int>(tileSubmission)] << '\n';
+}
+
+// the part of a run of tiles in the given chunk, relative to the chunk's first sample. False if there is none
+bool clipToChunk(const TileGrid::Range& range, const GridChunks::Chunk& chunk, TileGrid::Range& clipped) {
+    unsigned int chunkBegin{ static_cast<unsigned int>(chunk.firstSample) };
+    unsigned int chunkEnd{ chunkBegin + static_cast<unsigned int>(chunk.grid.size()) };
+    unsigned int begin{ std::max(range.first, chunkBegin) };
+    unsigned int end{ std::min(range.first + range.count, chunkEnd) };
+    if (begin >= end) {
+        return false;
+    }
+    clipped = TileGrid::Range{ begin - chunkBegin, end - begin };
+    return true;
+}
+
+void renderTiles(const std::vector<TileGrid::Range>& ranges, GridChunks& chunks) {
+    TRACE_GPU_ZONE("render tiles");
+    glBindVertexArray(cubeVAO);
+    glDisableVertexAttribArray(3);
+    glEnableVertexAttribArray(4);
+    glVertexAttribDivisor(4, 1);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, cubeEBO);
+
+    // the commands of every chunk are written first, the indirect buffer can't be mapped while it is drawn from
+    std::size_t commandOffset{};
+    bool indirect{ tileSubmission == TileSubmission::multiDrawIndirect && !ranges.empty() };
+    if (indirect) {
+        DrawElementsIndirectCommand* commands{ static_cast<DrawElementsIndirectCommand*>(tileCommandBuffer.map()) };
+        int count{ 0 };
+        for (const GridChunks::Chunk& chunk : chunks.getChunks()) {
+            TileGrid::Range clipped{};
+            for (const TileGrid::Range& range : ranges) {
+                if (clipToChunk(range, chunk, clipped)) {
+                    commands[count++] = DrawElementsIndirectCommand{ 36, clipped.count, 0, 0, clipped.first };
+                }
+            }
+        }
+        commandOffset = tileCommandBuffer.unmap();
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, tileCommandBuffer.getId());
+    }
+
+    for (int c{ 0 }; c < chunks.getCount(); ++c) {
+        const GridChunks::Chunk& chunk{ chunks.getChunks()[c] };
+        glBindBuffer(GL_ARRAY_BUFFER, chunkBuffers[c].tileSamples);
+        glVertexAttribIPointer(4, 1, GL_UNSIGNED_INT, sizeof(unsigned int), (void*)0);
+
+        int count{ 0 };
+        TileGrid::Range clipped{};
+        for (const TileGrid::Range& range : ranges) {
+            if (!clipToChunk(range, chunk, clipped)) {
+                continue;
+            }
+            ++count;
+            if (tileSubmission == TileSubmission::baseInstance) {
+                glDrawElementsInstancedBaseInstance(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0, clipped.count, clipped.first);
+            }
+            else if (tileSubmission == TileSubmission::attributeOffset) {
+                glVertexAttribIPointer(4, 1, GL_UNSIGNED_INT, sizeof(unsigned int), (void*)(clipped.first * sizeof(unsigned int)));
+                glDrawElementsInstanced(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0, clipped.count);
+            }
+        }
+        if (indirect && count > 0) {
+            glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (void*)commandOffset, count, 0);
+            commandOffset += count * sizeof(DrawElementsIndirectCommand);
+        }
+    }
+
+    if (indirect) {
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+        tileCommandBuffer.fence();
+    }
+    glDisableVertexAttribArray(4);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+}
+
+unsigned int meshEBO{ 0 };
+// indices of the strip between two rows, with the restart index in front of every strip but the first
+int meshStripIndices{ 0 };
+
+void createMeshVAO(int gridWidth, GridChunks& chunks) {
+    // one triangle strip per pair of neighbouring rows, separated by the restart index.
+    // The vertices have no attributes, the shader derives each sample from gl_VertexID.
+    // The strips of a chunk are the same relative to its first sample, so the indices of one
+    // chunk are drawn for every chunk with its first sample as the base vertex
+    const int rows{ chunks.getRowsPerChunk() };
+    std::vector<unsigned int> indices{};
+    indices.reserve(static_cast<std::size_t>(rows) * (2 * gridWidth + 1));
+    for (int row{ 0 }; row < rows; ++row) {
+        if (row > 0) {
+            indices.push_back(MESH_RESTART_INDEX);
+        }
+        for (int column{ 0 }; column < gridWidth; ++column) {
+            indices.push_back(static_cast<unsigned int>((row + 1) * gridWidth + column));
+            indices.push_back(static_cast<unsigned int>(row * gridWidth + column));
+        }
+    }
+    meshStripIndices = 2 * gridWidth + 1;
+
+    glGenVertexArrays(1, &meshVAO);
+    glGenBuffers(1, &meshEBO);
+
+    glBindVertexArray(meshVAO);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, meshEBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
+void renderMesh(GridChunks& chunks) {
+    TRACE_GPU_ZONE("render mesh");
+    glBindVertexArray(meshVAO);
+    glEnable(GL_PRIMITIVE_RESTART);
+    glPrimitiveRestartIndex(MESH_RESTART_INDEX);
+    for (int c{ 0 }; c < chunks.getCount(); ++c) {
+        const GridChunks::Chunk& chunk{ chunks.getChunks()[c] };
+        // a strip joins a row to the next, the last row of the grid has none
+        int strips{ chunk.grid.rows - (c == chunks.getCount() - 1 ? 1 : 0) };
+        if (strips > 0) {
+            glDrawElementsBaseVertex(GL_TRIANGLE_STRIP, strips * meshStripIndices - 1, GL_UNSIGNED_INT, 0, chunk.firstSample);
+        }
+    }
+    glDisable(GL_PRIMITIVE_RESTART);
+    glBindVertexArray(0);
+}
+
+unsigned int lodEBO{ 0 };
+
+void createLodVAO(int maxNodes) {
+    // every patch is the same grid of PATCH_QUADS x PATCH_QUADS quads, the shader places its vertices with the node
+    // attributes and gl_VertexID. All quads are split along the same diagonal, so a patch's odd vertices that morph
+    // onto their even neighbours leave exactly the triangles of the parent's grid
+    const int quads{ LodQuadtree::PATCH_QUADS };
+    const unsigned int rowVertices{ static_cast<unsigned int>(quads + 1) };
+    std::vector<unsigned int> indices{};
+    indices.reserve(static_cast<std::size_t>(quads) * quads * 6);
+    for (unsigned int row{ 0 }; row < static_cast<unsigned int>(quads); ++row) {
+        for (unsigned int column{ 0 }; column < static_cast<unsigned int>(quads); ++column) {
+            unsigned int corner{ row * rowVertices + column };
+            indices.insert(indices.end(), { corner, corner + 1, corner + rowVertices + 1, corner, corner + rowVertices + 1, corner + rowVertices });
+        }
+    }
+
+    glGenVertexArrays(1, &lodVAO);
+    glGenBuffers(1, &lodEBO);
+    // three frames in flight, like the instances. Whole multiples of 32 nodes keep every region a multiple of both
+    // the node size and the 256 bytes a region is aligned to, so each region starts at a whole node
+    std::size_t regionNodes{ (static_cast<std::size_t>(maxNodes) + 31) & ~static_cast<std::size_t>(31) };
+    lodNodeBuffer.create(GL_ARRAY_BUFFER, regionNodes * sizeof(LodQuadtree::Node), 3);
+
+    glBindVertexArray(lodVAO);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, lodEBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+    // the attributes point at the start of the buffer, the base instance picks the region of the frame
+    glBindBuffer(GL_ARRAY_BUFFER, lodNodeBuffer.getId());
+    glEnableVertexAttribArray(5);
+    glVertexAttribPointer(5, 3, GL_FLOAT, GL_FALSE, sizeof(LodQuadtree::Node), (void*)offsetof(LodQuadtree::Node, uStart));
+    glVertexAttribDivisor(5, 1);
+    glEnableVertexAttribArray(6);
+    glVertexAttribPointer(6, 2, GL_FLOAT, GL_FALSE, sizeof(LodQuadtree::Node), (void*)offsetof(LodQuadtree::Node, morphStart));
+    glVertexAttribDivisor(6, 1);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
+void renderLod(std::size_t bufferOffset, int nodeCount) {
+    TRACE_GPU_ZONE("render lod");
+    // one instance per node, its attributes are read from the region written this frame. Moving the attributes
+    // every frame would cost a vertex fetch variant per region on drivers that compile them, so the base instance
+    // skips to the region where the context has it
+    glBindVertexArray(lodVAO);
+    bool baseInstance{ GLAD_GL_ARB_base_instance != 0 };
+    if (!baseInstance) {
+        glBindBuffer(GL_ARRAY_BUFFER, lodNodeBuffer.getId());
+        glVertexAttribPointer(5, 3, GL_FLOAT, GL_FALSE, sizeof(LodQuadtree::Node), (void*)(bufferOffset + offsetof(LodQuadtree::Node, uStart)));
+        glVertexAttribPointer(6, 2, GL_FLOAT, GL_FALSE, sizeof(LodQuadtree::Node), (void*)(bufferOffset + offsetof(LodQuadtree::Node, morphStart)));
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+    if (nodeCount > 0) {
+        int indexCount{ LodQuadtree::PATCH_QUADS * LodQuadtree::PATCH_QUADS * 6 };
+        if (baseInstance) {
+            unsigned int firstNode{ static_cast<unsigned int>(bufferOffset / sizeof(LodQuadtree::Node)) };
+            glDrawElementsInstancedBaseInstance(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0, nodeCount, firstNode);
+        }
+        else {
+            glDrawElementsInstanced(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0, nodeCount);
+        }
+    }
+    glBindVertexArray(0);
+    lodNodeBuffer.fence();
+}
+
+void createTessellationVAO(int patchCount) {
+    // three frames in flight. The regions are aligned to 256 bytes, so each starts at a whole patch index
+    tessellationPatchBuffer.create(GL_ARRAY_BUFFER, static_cast<std::size_t>(patchCount) * sizeof(unsigned int), 3);
+
+    // the patches have no vertex attributes, the vertex stage places their corners with gl_VertexID. The index
+    // of the patch is an instance attribute that points at the start of the buffer, the base instance picks the region
+    glGenVertexArrays(1, &tessellationVAO);
+    glBindVertexArray(tessellationVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, tessellationPatchBuffer.getId());
+    glEnableVertexAttribArray(4);
+    glVertexAttribIPointer(4, 1, GL_UNSIGNED_INT, sizeof(unsigned int), (void*)0);
+    glVertexAttribDivisor(4, 1);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    glPatchParameteri(GL_PATCH_VERTICES, 4);
+}
+
+void renderTessellation(std::size_t bufferOffset, int patchCount) {
+    TRACE_GPU_ZONE("render tessellation");
+    glBindVertexArray(tessellationVAO);
+    bool baseInstance{ GLAD_GL_ARB_base_instance != 0 };
+    if (!baseInstance) {
+        glBindBuffer(GL_ARRAY_BUFFER, tessellationPatchBuffer.getId());
+        glVertexAttribIPointer(4, 1, GL_UNSIGNED_INT, sizeof(unsigned int), (void*)bufferOffset);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+    if (patchCount > 0) {
+        // one four corner patch per visible patch index
+        if (baseInstance) {
+            unsigned int firstPatch{ static_cast<unsigned int>(bufferOffset / sizeof(unsigned int)) };
+            // Mesa's software tessellator is created anew on every patch draw
+            ALLOW_ALLOCATIONS();
+            glDrawArraysInstancedBaseInstance(GL_PATCHES, 0, 4, patchCount, firstPatch);
+        }
+        else {
+            ALLOW_ALLOCATIONS();
+            glDrawArraysInstanced(GL_PATCHES, 0, 4, patchCount);
+        }
+    }
+    glBindVertexArray(0);
+    tessellationPatchBuffer.fence();
 }
\ No newline at end of file
@@ -0,0 +1,190 @@
+#include <options.h>
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+namespace {
+	void printUsage(const char* program) {
+		std::cerr << "Usage: " << program << " [options]\n"
+			<< "  --mode <upload|stream|procedural|faces|tiles|mesh|lod|tessellation>\n"
+			<< "                                                 how the surface is drawn (default: upload)\n"
+			<< "  --instance-format <float3|short2|half2|packed> layout of the instances of upload and stream (default: float3)\n"
+			<< "  --grid <width>                                 samples per row and column of the grid (default: "
+			<< Options::DEFAULT_GRID_WIDTH << ")\n"
+			<< "  --chunk <samples>                              most samples per buffer and draw, larger grids are split\n"
+			<< "                                                 into chunks of rows (default: " << GridChunks::DEFAULT_MAX_SAMPLES << ")\n"
+			<< "  --lod-error <pixels>                           largest on-screen vertex step of the lod mode (default: "
+			<< LodQuadtree::DEFAULT_PIXEL_ERROR << ")\n"
+			<< "  --tessellation-error <pixels>                  largest on-screen error of the tessellation mode (default: "
+			<< TessellationPatches::DEFAULT_PIXEL_ERROR << ")\n"
+			<< "  --headless                                     render offscreen without a window or display\n"
+			<< "  --frames <count>                               exit after count frames (default: "
+			<< Options::DEFAULT_HEADLESS_FRAMES << " when headless, unlimited otherwise)\n"
+			<< "  --replay <file>                                fly the camera path in file with a fixed timestep and\n"
+			<< "                                                 report frame time percentiles, over the path and at\n"
+			<< "                                                 least one morph cycle unless --frames is given\n"
+			<< "  --timestep <seconds>                           animation time per replayed frame (default: 1/60)\n"
+			<< "  --trace <file>                                 write the traced zones of the run as Chrome trace JSON\n"
+			<< "  --shader-cache <directory>                     keep linked programs in directory (default: "
+			<< Options::DEFAULT_SHADER_CACHE << ")\n"
+			<< "  --no-shader-cache                              compile every program from source\n"
+			<< "  --shader-dir <directory>                       load position.vert and position.frag from directory and\n"
+			<< "                                                 rebuild the programs whenever they change\n";
+	}
+
+	bool instanceFormat(const std::string& value, InstanceKernel::Format& format) {
+		for (InstanceKernel::Format candidate : { InstanceKernel::Format::float3, InstanceKernel::Format::short2,
+			InstanceKernel::Format::half2, InstanceKernel::Format::packed }) {
+			if (value == InstanceKernel::formatName(candidate)) {
+				format = candidate;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	// a whole number of at least minimum that fits an int
+	bool wholeNumber(const std::string& value, int minimum) {
+		if (value.empty() || value.size() >= 10 || value.find_first_not_of("0123456789") != std::string::npos) {
+			return false;
+		}
+		return std::stoi(value) >= minimum;
+	}
+
+	bool positiveNumber(const std::string& value) {
+		std::size_t length{};
+		try {
+			return std::stof(value, &length) > 0.0f && length == value.size();
+		}
+		catch (const std::exception&) {
+			return false;
+		}
+	}
+}
+
+bool parseOptions(int argc, char* argv[], Options& options) {
+	for (int i{ 1 }; i < argc; ++i) {
+		std::string argument{ argv[i] };
+		std::string value{ i + 1 < argc ? argv[i + 1] : "" };
+
+		if (argument == "--mode" && value == "upload") {
+			options.renderMode = RenderMode::instanceUpload;
+			++i;
+		}
+		else if (argument == "--mode" && value == "stream") {
+			options.renderMode = RenderMode::instanceStream;
+			++i;
+		}
+		else if (argument == "--mode" && value == "procedural") {
+			options.renderMode = RenderMode::procedural;
+			++i;
+		}
+		else if (argument == "--mode" && value == "faces") {
+			options.renderMode = RenderMode::visibleFaces;
+			++i;
+		}
+		else if (argument == "--mode" && value == "tiles") {
+			options.renderMode = RenderMode::tiles;
+			++i;
+		}
+		else if (argument == "--mode" && value == "mesh") {
+			options.renderMode = RenderMode::mesh;
+			++i;
+		}
+		else if (argument == "--mode" && value == "lod") {
+			options.renderMode = RenderMode::lod;
+			++i;
+		}
+		else if (argument == "--mode" && value == "tessellation") {
+			options.renderMode = RenderMode::tessellation;
+			++i;
+		}
+		else if (argument == "--instance-format" && instanceFormat(value, options.instanceFormat)) {
+			++i;
+		}
+		else if (argument == "--grid" && wholeNumber(value, 2)) {
+			options.gridWidth = std::stoi(value);
+			++i;
+		}
+		else if (argument == "--chunk" && wholeNumber(value, 1)) {
+			options.chunkSamples = std::stoi(value);
+			++i;
+		}
+		else if (argument == "--lod-error" && positiveNumber(value)) {
+			options.lodPixelError = std::stof(value);
+			++i;
+		}
+		else if (argument == "--tessellation-error" && positiveNumber(value)) {
+			options.tessellationPixelError = std::stof(value);
+			++i;
+		}
+		else if (argument == "--headless") {
+			options.headless = true;
+		}
+		else if (argument == "--frames" && wholeNumber(value, 0)) {
+			options.frames = std::stoi(value);
+			++i;
+		}
+		else if (argument == "--replay" && !value.empty()) {
+			options.replayPath = value;
+			++i;
+		}
+		else if (argument == "--timestep" && positiveNumber(value)) {
+			options.timestep = std::stof(value);
+			++i;
+		}
+		else if (argument == "--trace" && !value.empty()) {
+			options.tracePath = value;
+			++i;
+		}
+		else if (argument == "--shader-cache" && !value.empty()) {
+			options.shaderCachePath = value;
+			++i;
+		}
+		else if (argument == "--no-shader-cache") {
+			options.shaderCachePath.clear();
+		}
+		else if (argument == "--shader-dir" && !value.empty()) {
+			options.shaderDirectory = value;
+			++i;
+		}
+		else {
+			std::cerr << "| ERROR::OPTIONS: Invalid argument: " << argument << '\n';
+			printUsage(argv[0]);
+			return false;
+		}
+	}
+	// a replay covers the whole path unless a count is given
+	if (options.headless && options.frames == 0 && options.replayPath.empty()) {
+		options.frames = Options::DEFAULT_HEADLESS_FRAMES;
+	}
+	return true;
+}
+
+const char* renderModeName(RenderMode mode) {
+	switch (mode) {
+	case RenderMode::instanceUpload:	return "instance upload";
+	case RenderMode::instanceStream:	return "streamed instances";
+	case RenderMode::procedural:		return "procedural instancing";
+	case RenderMode::visibleFaces:		return "visible faces";
+	case RenderMode::tiles:				return "frustum culled tiles";
+	case RenderMode::mesh:				return "triangle mesh";
+	case RenderMode::lod:				return "distance LOD patches";
+	case RenderMode::tessellation:		return "tessellated patches";
+	default:							return "unknown";
+	}
+}
+
+RenderMode nextRenderMode(RenderMode mode) {
+	switch (mode) {
+	case RenderMode::instanceUpload:	return RenderMode::instanceStream;
+	case RenderMode::instanceStream:	return RenderMode::procedural;
+	case RenderMode::procedural:		return RenderMode::visibleFaces;
+	case RenderMode::visibleFaces:		return RenderMode::tiles;
+	case RenderMode::tiles:				return RenderMode::mesh;
+	case RenderMode::mesh:				return RenderMode::lod;
+	case RenderMode::lod:				return RenderMode::tessellation;
+	default:							return RenderMode::instanceUpload;
+	}
+}
\ No newline at end of file
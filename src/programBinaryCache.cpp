@@ -0,0 +1,191 @@
+#include <programBinaryCache.h>
+
+#include <glad/glad.h>
+
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+namespace {
+	// start of every cache file, the key is repeated so a renamed or truncated file is never loaded
+	struct FileHeader {
+		char magic[4]{ 'G', 'L', 'P', 'B' };
+		std::uint32_t version{ 1 };
+		std::uint64_t key{};
+		std::uint32_t format{};
+		std::uint32_t length{};
+	};
+
+	// 64 bit FNV-1a, continued from the given hash
+	std::uint64_t hashOf(std::string_view text, std::uint64_t hash = 14695981039346656037ull) {
+		for (char c : text) {
+			hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+		}
+		// a separator, so moving text from one part to the next changes the hash
+		return (hash ^ 0xFF) * 1099511628211ull;
+	}
+
+	// a suffix no other store() uses, in this process (the counter) or another one (the random part drawn once
+	// per process), so two launches writing the same key never write into one temporary file
+	std::string uniqueSuffix() {
+		static const std::uint64_t process{ (std::uint64_t{ std::random_device{}() } << 32) ^ std::random_device{}() };
+		static std::atomic<std::uint64_t> counter{};
+		std::ostringstream suffix{};
+		suffix << '.' << std::hex << process << '.' << counter.fetch_add(1, std::memory_order_relaxed) << ".tmp";
+		return suffix.str();
+	}
+
+	std::string glString(GLenum name) {
+		const GLubyte* text{ glGetString(name) };
+		return text != nullptr ? reinterpret_cast<const char*>(text) : "";
+	}
+}
+
+bool ProgramBinaryCache::open(const std::string& directory) {
+	m_enabled = false;
+	int formats{};
+	if (GLAD_GL_ARB_get_program_binary) {
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+	}
+	if (formats == 0) {
+		std::cerr << "| ERROR::PROGRAM_BINARY_CACHE: The driver has no program binary formats, shaders are compiled on every launch\n";
+		return false;
+	}
+
+	std::error_code error{};
+	std::filesystem::create_directories(directory, error);
+	if (error) {
+		std::cerr << "| ERROR::PROGRAM_BINARY_CACHE: Failed to create " << directory << ": " << error.message() << '\n';
+		return false;
+	}
+
+	m_directory = directory;
+	m_driver = glString(GL_VENDOR) + '\n' + glString(GL_RENDERER) + '\n' + glString(GL_VERSION) + '\n' + glString(GL_SHADING_LANGUAGE_VERSION);
+	m_enabled = true;
+	return true;
+}
+
+std::uint64_t ProgramBinaryCache::key(const ShaderSources& sources, const char* defines) const {
+	std::uint64_t hash{ hashOf(m_driver) };
+	for (const char* text : { sources.vertex, sources.fragment, sources.geometry, defines }) {
+		hash = hashOf(text != nullptr ? text : "", hash);
+	}
+	// the tessellation stages only count when there are any, so the other programs keep their keys
+	if (sources.tessControl != nullptr || sources.tessEvaluation != nullptr) {
+		for (const char* text : { sources.tessControl, sources.tessEvaluation }) {
+			hash = hashOf(text != nullptr ? text : "", hash);
+		}
+	}
+	return hash;
+}
+
+bool ProgramBinaryCache::load(unsigned int program, std::uint64_t key) {
+	if (!m_enabled) {
+		return false;
+	}
+
+	std::filesystem::path path{ m_file(key) };
+	std::ifstream file{ path, std::ios::binary };
+	FileHeader header{};
+	if (!file || !file.read(reinterpret_cast<char*>(&header), sizeof(header))
+		|| std::memcmp(header.magic, FileHeader{}.magic, sizeof(header.magic)) != 0
+		|| header.version != FileHeader{}.version || header.key != key) {
+		++m_misses;
+		return false;
+	}
+	// the length comes from the file too, a damaged one could ask for gigabytes
+	std::error_code error{};
+	std::uintmax_t size{ std::filesystem::file_size(path, error) };
+	if (error || size != sizeof(FileHeader) + std::uintmax_t{ header.length }) {
+		++m_misses;
+		return false;
+	}
+	std::vector<char> binary(header.length);
+	if (!file.read(binary.data(), static_cast<std::streamsize>(binary.size()))) {
+		++m_misses;
+		return false;
+	}
+
+	// the driver may still refuse a binary, for example after an update that kept its version string
+	glProgramBinary(program, header.format, binary.data(), static_cast<int>(binary.size()));
+	int linked{};
+	glGetProgramiv(program, GL_LINK_STATUS, &linked);
+	if (!linked) {
+		++m_rejected;
+		return false;
+	}
+	++m_hits;
+	return true;
+}
+
+void ProgramBinaryCache::store(unsigned int program, std::uint64_t key) {
+	if (!m_enabled) {
+		return;
+	}
+
+	int length{};
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0) {
+		return;
+	}
+	std::vector<char> binary(static_cast<std::size_t>(length));
+	FileHeader header{};
+	header.key = key;
+	GLenum format{};
+	glGetProgramBinary(program, length, &length, &format, binary.data());
+	header.format = format;
+	header.length = static_cast<std::uint32_t>(length);
+
+	// written next to the final name under a name of its own and renamed, so a concurrent launch never reads
+	// half a file and two launches storing the same key never interleave their writes
+	std::filesystem::path path{ m_file(key) };
+	std::filesystem::path temporary{ path };
+	temporary += uniqueSuffix();
+	{
+		std::ofstream file{ temporary, std::ios::binary | std::ios::trunc };
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(binary.data(), length);
+		if (!file) {
+			std::cerr << "| ERROR::PROGRAM_BINARY_CACHE: Failed to write " << temporary.string() << '\n';
+			file.close();
+			std::error_code error{};
+			std::filesystem::remove(temporary, error);
+			return;
+		}
+	}
+	std::error_code error{};
+	std::filesystem::rename(temporary, path, error);
+	if (error) {
+		std::cerr << "| ERROR::PROGRAM_BINARY_CACHE: Failed to write " << path.string() << ": " << error.message() << '\n';
+		std::filesystem::remove(temporary, error);
+	}
+}
+
+void ProgramBinaryCache::printSummary() {
+	if (!m_enabled) {
+		return;
+	}
+	std::cout << "| PROGRAM_BINARY_CACHE: " << m_hits << " programs loaded from " << m_directory.string() << ", "
+		<< m_misses + m_rejected << " compiled from source";
+	if (m_rejected > 0) {
+		std::cout << " (" << m_rejected << " binaries rejected by the driver)";
+	}
+	std::cout << '\n';
+}
+
+bool ProgramBinaryCache::isEnabled() {
+	return m_enabled;
+}
+
+std::filesystem::path ProgramBinaryCache::m_file(std::uint64_t key) const {
+	std::ostringstream name{};
+	name << std::hex << std::setw(16) << std::setfill('0') << key << ".bin";
+	return m_directory / name.str();
+}
\ No newline at end of file
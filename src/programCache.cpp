@@ -0,0 +1,77 @@
+#include <programCache.h>
+
+void ProgramCache::compile(const ShaderSources& sources, const std::string& defines, ProgramBinaryCache* binaryCache) {
+	m_sources = sources;
+	m_defines = defines;
+	m_binaryCache = binaryCache;
+
+	// the five surfaces on their own and the five transitions of the cycle
+	for (float time{ 0.0f }; time < Morph::CYCLE; time += 1.0f) {
+		MorphState state{ Morph::at(time) };
+		if (m_programs[static_cast<int>(state.from)][static_cast<int>(state.to)].getId() == 0) {
+			m_compile(state.from, state.to);
+		}
+	}
+}
+
+std::vector<std::future<bool>> ProgramCache::submit(ShaderCompiler& compiler, const ShaderSources& sources, const std::string& defines,
+	ProgramBinaryCache* binaryCache) {
+	m_sources = sources;
+	m_defines = defines;
+	m_binaryCache = binaryCache;
+
+	std::vector<std::future<bool>> linked{};
+	// a queued program has no id until the compiler starts it, so the states submitted here are counted apart
+	bool submitted[Surfaces::COUNT][Surfaces::COUNT]{};
+	for (float time{ 0.0f }; time < Morph::CYCLE; time += 1.0f) {
+		MorphState state{ Morph::at(time) };
+		bool& queued{ submitted[static_cast<int>(state.from)][static_cast<int>(state.to)] };
+		Shader& program{ m_programs[static_cast<int>(state.from)][static_cast<int>(state.to)] };
+		if (program.getId() == 0 && !queued) {
+			queued = true;
+			std::string stateDefines{ m_defines + surfaceDefines(state.from, state.to) };
+			linked.push_back(compiler.submit(program, m_sources, stateDefines.c_str(), m_binaryCache));
+		}
+	}
+	return linked;
+}
+
+void ProgramCache::destroy() {
+	for (auto& row : m_programs) {
+		for (Shader& program : row) {
+			program.destroy();
+		}
+	}
+}
+
+Shader& ProgramCache::get(const MorphState& state) {
+	Shader& program{ m_programs[static_cast<int>(state.from)][static_cast<int>(state.to)] };
+	if (program.getId() == 0) {
+		// not part of the cycle, build it on first use
+		m_compile(state.from, state.to);
+	}
+	return program;
+}
+
+unsigned long long ProgramCache::getSkippedUploads() {
+	unsigned long long skipped{};
+	for (auto& row : m_programs) {
+		for (Shader& program : row) {
+			skipped += program.getSkippedUploads();
+		}
+	}
+	return skipped;
+}
+
+std::string ProgramCache::surfaceDefines(Surfaces::Surface from, Surfaces::Surface to) {
+	std::string defines{ "#define SURFACE_FROM " + std::string{ Surfaces::name(from) } + '\n' };
+	if (from != to) {
+		defines += "#define SURFACE_TO " + std::string{ Surfaces::name(to) } + '\n';
+	}
+	return defines;
+}
+
+void ProgramCache::m_compile(Surfaces::Surface from, Surfaces::Surface to) {
+	std::string defines{ m_defines + surfaceDefines(from, to) };
+	m_programs[static_cast<int>(from)][static_cast<int>(to)].compile(m_sources, defines.c_str(), m_binaryCache);
+}
\ No newline at end of file
@@ -0,0 +1,184 @@
+#include <rendererPrograms.h>
+
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <utility>
+
+namespace {
+	const char* VERTEX_FILE{ "position.vert" };
+	const char* FRAGMENT_FILE{ "position.frag" };
+}
+
+void RendererPrograms::ProgramSet::destroy() {
+	cubes.destroy();
+	sampleList.destroy();
+	mesh.destroy();
+	lod.destroy();
+	tessellation.destroy();
+}
+
+unsigned long long RendererPrograms::ProgramSet::skippedUploads() {
+	return cubes.getSkippedUploads() + sampleList.getSkippedUploads() + mesh.getSkippedUploads() + lod.getSkippedUploads()
+		+ tessellation.getSkippedUploads();
+}
+
+void RendererPrograms::setInstanceDefines(const std::string& defines) {
+	m_instanceDefines = defines;
+}
+
+void RendererPrograms::submit(ShaderCompiler& compiler, const char* vertexSource, const char* fragmentSource, ProgramBinaryCache* binaryCache) {
+	m_compiler = &compiler;
+	m_binaryCache = binaryCache;
+	m_current = m_submit(vertexSource, fragmentSource);
+}
+
+bool RendererPrograms::submitFromDirectory(ShaderCompiler& compiler, const std::string& directory, ProgramBinaryCache* binaryCache) {
+	m_compiler = &compiler;
+	m_binaryCache = binaryCache;
+	m_directory = directory;
+
+	std::filesystem::path path{ directory };
+	if (!m_watcher.watch((path / VERTEX_FILE).string()) || !m_watcher.watch((path / FRAGMENT_FILE).string())) {
+		return false;
+	}
+	m_current = m_load();
+	if (m_current == nullptr) {
+		return false;
+	}
+	std::cout << "| SHADER_RELOAD: Watching " << directory << " for changes to " << VERTEX_FILE << " and " << FRAGMENT_FILE
+		<< (m_compiler->isParallel() ? "\n" : ", the driver can't compile in the background so a reload builds one program per frame\n");
+	return true;
+}
+
+void RendererPrograms::update() {
+	if (m_watcher.poll()) {
+		// the set being built is already out of date, but its programs can't be taken from the compiler
+		if (m_pending != nullptr) {
+			m_changedWhilePending = true;
+		}
+		else {
+			m_pending = m_load();
+		}
+	}
+	if (m_pending == nullptr) {
+		return;
+	}
+
+	m_compiler->poll();
+	m_finishPending();
+	if (m_pending == nullptr && m_changedWhilePending) {
+		m_changedWhilePending = false;
+		m_pending = m_load();
+	}
+}
+
+void RendererPrograms::destroy() {
+	if (m_pending != nullptr) {
+		m_compiler->waitAll();
+		m_pending->destroy();
+		m_pending.reset();
+	}
+	if (m_current != nullptr) {
+		m_current->destroy();
+		m_current.reset();
+	}
+}
+
+std::unique_ptr<RendererPrograms::ProgramSet> RendererPrograms::m_load() {
+	std::filesystem::path path{ m_directory };
+	std::string vertexSource{};
+	std::string fragmentSource{};
+	if (!ShaderWatcher::readSource((path / VERTEX_FILE).string(), vertexSource)
+		|| !ShaderWatcher::readSource((path / FRAGMENT_FILE).string(), fragmentSource)) {
+		return nullptr;
+	}
+	return m_submit(std::move(vertexSource), std::move(fragmentSource));
+}
+
+std::unique_ptr<RendererPrograms::ProgramSet> RendererPrograms::m_submit(std::string vertexSource, std::string fragmentSource) {
+	auto set{ std::make_unique<ProgramSet>() };
+	set->vertexSource = std::move(vertexSource);
+	set->fragmentSource = std::move(fragmentSource);
+	const char* vertex{ set->vertexSource.c_str() };
+	const char* fragment{ set->fragmentSource.c_str() };
+
+	ShaderSources sources{ vertex, fragment };
+	for (auto [cache, defines] : { std::pair{ &set->cubes, m_instanceDefines.c_str() }, std::pair{ &set->sampleList, "#define SAMPLE_LIST\n" },
+		std::pair{ &set->mesh, "#define SURFACE_MESH\n" }, std::pair{ &set->lod, "#define SURFACE_LOD\n" } }) {
+		for (std::future<bool>& linked : cache->submit(*m_compiler, sources, defines, m_binaryCache)) {
+			set->linked.push_back(std::move(linked));
+		}
+	}
+	// the vertex source also holds the tessellation stages, which only exist with the extension
+	if (GLAD_GL_ARB_tessellation_shader) {
+		ShaderSources tessellated{ vertex, fragment, nullptr, vertex, vertex };
+		for (std::future<bool>& linked : set->tessellation.submit(*m_compiler, tessellated, "#define SURFACE_TESSELLATION\n", m_binaryCache)) {
+			set->linked.push_back(std::move(linked));
+		}
+	}
+	return set;
+}
+
+void RendererPrograms::m_finishPending() {
+	for (std::future<bool>& linked : m_pending->linked) {
+		if (linked.wait_for(std::chrono::seconds{ 0 }) != std::future_status::ready) {
+			return;
+		}
+	}
+
+	bool success{ true };
+	for (std::future<bool>& linked : m_pending->linked) {
+		success = linked.get() && success;
+	}
+	if (!success) {
+		// the compile and link errors were printed when the programs were finished
+		++m_failedReloads;
+		m_pending->destroy();
+		m_pending.reset();
+		std::cerr << "| ERROR::SHADER_RELOAD: The changed shaders failed to build, still drawing with the last working programs\n";
+		return;
+	}
+
+	++m_reloads;
+	m_retiredSkippedUploads += m_current->skippedUploads();
+	m_current->destroy();
+	m_current = std::move(m_pending);
+	std::cout << "| SHADER_RELOAD: Reloaded " << m_current->linked.size() << " programs\n";
+}
+
+ProgramCache& RendererPrograms::getCubes() {
+	return m_current->cubes;
+}
+
+ProgramCache& RendererPrograms::getSampleList() {
+	return m_current->sampleList;
+}
+
+ProgramCache& RendererPrograms::getMesh() {
+	return m_current->mesh;
+}
+
+ProgramCache& RendererPrograms::getLod() {
+	return m_current->lod;
+}
+
+ProgramCache& RendererPrograms::getTessellation() {
+	return m_current->tessellation;
+}
+
+unsigned long long RendererPrograms::getSkippedUploads() {
+	unsigned long long skipped{ m_retiredSkippedUploads };
+	if (m_current != nullptr) {
+		skipped += m_current->skippedUploads();
+	}
+	return skipped;
+}
+
+unsigned int RendererPrograms::getReloadCount() {
+	return m_reloads;
+}
+
+unsigned int RendererPrograms::getFailedReloadCount() {
+	return m_failedReloads;
+}
\ No newline at end of file
@@ -0,0 +1,68 @@
+#include <replayStats.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+namespace {
+	// nearest rank percentile of sorted samples
+	double percentile(const std::vector<double>& sorted, double fraction) {
+		std::size_t rank{ static_cast<std::size_t>(std::ceil(fraction * static_cast<double>(sorted.size()))) };
+		return sorted[std::clamp<std::size_t>(rank, 1, sorted.size()) - 1];
+	}
+}
+
+void ReplayStats::reserve(int frames) {
+	m_phases.reserve(static_cast<std::size_t>(Surfaces::COUNT) * Surfaces::COUNT);
+	m_samples.reserve(static_cast<std::size_t>(std::max(frames, 0)));
+}
+
+void ReplayStats::addFrame(const MorphState& state, double frameTime) {
+	// only the surfaces identify a phase, the blend changes every frame
+	auto phase{ std::find_if(m_phases.begin(), m_phases.end(), [&state](const MorphState& phase) {
+		return phase.from == state.from && phase.to == state.to;
+	}) };
+	if (phase == m_phases.end()) {
+		m_phases.push_back(state);
+		phase = m_phases.end() - 1;
+	}
+	m_samples.push_back(Sample{ static_cast<int>(phase - m_phases.begin()), frameTime });
+}
+
+void ReplayStats::printSummary() {
+	for (std::size_t i{ 0 }; i < m_phases.size(); ++i) {
+		std::vector<double> frameTimes{};
+		for (const Sample& sample : m_samples) {
+			if (sample.phase == static_cast<int>(i)) {
+				frameTimes.push_back(sample.frameTime);
+			}
+		}
+		std::string label{ Surfaces::name(m_phases[i].from) };
+		if (m_phases[i].isTransition()) {
+			label += std::string{ " -> " } + Surfaces::name(m_phases[i].to);
+		}
+		m_print(label.c_str(), std::move(frameTimes));
+	}
+	if (!m_samples.empty()) {
+		std::vector<double> all{};
+		all.reserve(m_samples.size());
+		for (const Sample& sample : m_samples) {
+			all.push_back(sample.frameTime);
+		}
+		m_print("all phases", std::move(all));
+	}
+}
+
+void ReplayStats::m_print(const char* label, std::vector<double> frameTimes) {
+	std::sort(frameTimes.begin(), frameTimes.end());
+	std::streamsize precision{ std::cout.precision() };
+	std::cout << "| REPLAY: " << std::left << std::setw(20) << label << std::right << std::setw(6) << frameTimes.size() << " frames"
+		<< std::fixed << std::setprecision(2)
+		<< " | p50 " << percentile(frameTimes, 0.50) * 1000.0 << " ms"
+		<< " | p95 " << percentile(frameTimes, 0.95) * 1000.0 << " ms"
+		<< " | p99 " << percentile(frameTimes, 0.99) * 1000.0 << " ms"
+		<< " | max " << frameTimes.back() * 1000.0 << " ms\n"
+		<< std::defaultfloat << std::setprecision(precision);
+}
\ No newline at end of file
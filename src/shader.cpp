@@ -1,136 +1,275 @@
 #include <shader.h>
+#include <frameUniforms.h>
 
+#include <algorithm>
+#include <cstring>
 #include <iostream>
+#include <string_view>
 
 Shader& Shader::use() {
 	glUseProgram(m_ID);
 	return *this;
 }
 
-void Shader::compile(const char* vertexSource, const char* fragmentSource, const char* geometrySource) {
-	unsigned int sVertex{};
-	unsigned int sFragment{};
-	unsigned int sGeometry{};
-
-	// vertex shader
-	sVertex = glCreateShader(GL_VERTEX_SHADER);
-	glShaderSource(sVertex, 1, &vertexSource, nullptr);
-	glCompileShader(sVertex);
-	m_checkCompileErrors(sVertex, "VERTEX");
-
-	// fragment shader
-	sFragment = glCreateShader(GL_FRAGMENT_SHADER);
-	glShaderSource(sFragment, 1, &fragmentSource, nullptr);
-	glCompileShader(sFragment);
-	m_checkCompileErrors(sFragment, "FRAGMENT");
+void Shader::compile(const ShaderSources& sources, const char* defines, ProgramBinaryCache* binaryCache) {
+	beginCompile(sources, defines, binaryCache);
+	finishCompile();
+}
 
-	// if geometry shader source code is given, also compile geometry shader
-	if (geometrySource != nullptr) {
-		sGeometry = glCreateShader(GL_GEOMETRY_SHADER);
-		glShaderSource(sGeometry, 1, &geometrySource, nullptr);
-		glCompileShader(sGeometry);
-		m_checkCompileErrors(sGeometry, "GEOMETRY");
+void Shader::beginCompile(const ShaderSources& sources, const char* defines, ProgramBinaryCache* binaryCache) {
+	m_pending = PendingBuild{};
+	if (binaryCache != nullptr && binaryCache->isEnabled()) {
+		m_pending.binaryKey = binaryCache->key(sources, defines);
+		m_ID = glCreateProgram();
+		if (binaryCache->load(m_ID, m_pending.binaryKey)) {
+			m_linked();
+			return;
+		}
+		glDeleteProgram(m_ID);
+		m_pending.binaryCache = binaryCache;
 	}
 
+	// nothing is checked until finishCompile, so with parallel compilation the driver works on every stage and the link at once
+	m_addStage(GL_VERTEX_SHADER, "VERTEX", sources.vertex, defines);
+	m_addStage(GL_FRAGMENT_SHADER, "FRAGMENT", sources.fragment, defines);
+	// the optional stages are only compiled if their source code is given
+	m_addStage(GL_GEOMETRY_SHADER, "GEOMETRY", sources.geometry, defines);
+	m_addStage(GL_TESS_CONTROL_SHADER, "TESS_CONTROL", sources.tessControl, defines);
+	m_addStage(GL_TESS_EVALUATION_SHADER, "TESS_EVALUATION", sources.tessEvaluation, defines);
+
 	// shader program
 	m_ID = glCreateProgram();
-	glAttachShader(m_ID, sVertex);
-	glAttachShader(m_ID, sFragment);
-	if (geometrySource != nullptr) {
-		glAttachShader(m_ID, sGeometry);
+	for (int i{ 0 }; i < m_pending.stageCount; ++i) {
+		glAttachShader(m_ID, m_pending.stages[i]);
+	}
+	if (m_pending.binaryCache != nullptr) {
+		glProgramParameteri(m_ID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
 	}
 	glLinkProgram(m_ID);
+	m_pending.active = true;
+}
+
+bool Shader::isCompileReady() {
+	if (!m_pending.active) {
+		return true;
+	}
+	// without the extension there is no way to ask, finishCompile simply waits
+	if (!GLAD_GL_KHR_parallel_shader_compile && !GLAD_GL_ARB_parallel_shader_compile) {
+		return true;
+	}
+	int complete{};
+	glGetProgramiv(m_ID, GL_COMPLETION_STATUS_KHR, &complete);
+	return complete != 0;
+}
+
+bool Shader::finishCompile() {
+	if (!m_pending.active) {
+		return m_ID != 0;
+	}
+	m_pending.active = false;
+
+	for (int i{ 0 }; i < m_pending.stageCount; ++i) {
+		m_checkCompileErrors(m_pending.stages[i], m_pending.stageNames[i]);
+	}
 	m_checkCompileErrors(m_ID, "PROGRAM");
 
 	// delete the shaders as they're linked into our program now and no longer necessary
-	glDeleteShader(sVertex);
-	glDeleteShader(sFragment);
-	if (geometrySource != nullptr) {
-		glDeleteShader(sGeometry);
+	for (int i{ 0 }; i < m_pending.stageCount; ++i) {
+		glDeleteShader(m_pending.stages[i]);
 	}
-}
 
-void Shader::setFloat(const char* name, float value, bool useShader) {
-	if (useShader) {
-		use();
+	int linked{};
+	glGetProgramiv(m_ID, GL_LINK_STATUS, &linked);
+	if (m_pending.binaryCache != nullptr && linked) {
+		m_pending.binaryCache->store(m_ID, m_pending.binaryKey);
 	}
-	glUniform1f(glGetUniformLocation(m_ID, name), value);
+	m_linked();
+	return linked != 0;
 }
 
-void Shader::setInteger(const char* name, int value, bool useShader) {
-	if (useShader) {
-		use();
+void Shader::destroy() {
+	if (m_ID != 0) {
+		glDeleteProgram(m_ID);
 	}
-	glUniform1i(glGetUniformLocation(m_ID, name), value);
+	m_ID = 0;
+	m_pending = PendingBuild{};
+	m_uniforms.clear();
 }
 
-void Shader::setVector2f(const char* name, float x, float y, bool useShader) {
-	if (useShader) {
-		use();
+void Shader::m_linked() {
+	// the per-frame block is always at the same binding, GLSL 3.30 can't set it in the source
+	unsigned int frameBlock{ glGetUniformBlockIndex(m_ID, FrameUniforms::BLOCK_NAME) };
+	if (frameBlock != GL_INVALID_INDEX) {
+		glUniformBlockBinding(m_ID, frameBlock, FrameUniforms::BINDING);
 	}
-	glUniform2f(glGetUniformLocation(m_ID, name), x, y);
+
+	m_reflectUniforms();
 }
 
-void Shader::setVector2f(const char* name, const glm::vec2& value, bool useShader) {
-	if (useShader) {
-		use();
+void Shader::m_reflectUniforms() {
+	int count{};
+	int maxLength{};
+	glGetProgramiv(m_ID, GL_ACTIVE_UNIFORMS, &count);
+	glGetProgramiv(m_ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+
+	// at most half full, so a lookup almost always hits on the first slot
+	std::size_t slots{ 1 };
+	while (slots < 2 * static_cast<std::size_t>(count)) {
+		slots *= 2;
 	}
-	glUniform2f(glGetUniformLocation(m_ID, name), value.x, value.y);
-}
+	m_uniforms.assign(slots, Uniform{});
 
-void Shader::setVector3f(const char* name, float x, float y, float z, bool useShader) {
-	if (useShader) {
-		use();
+	std::string name(static_cast<std::size_t>(std::max(maxLength, 1)), '\0');
+	for (int i{ 0 }; i < count; ++i) {
+		int length{};
+		int size{};
+		GLenum type{};
+		glGetActiveUniform(m_ID, static_cast<unsigned int>(i), maxLength, &length, &size, &type, name.data());
+		std::string_view view{ name.data(), static_cast<std::size_t>(length) };
+		int location{ glGetUniformLocation(m_ID, name.c_str()) };
+		// uniforms in blocks have no location and are set through their buffer
+		if (location < 0) {
+			continue;
+		}
+		// arrays are reported as name[0], they are set by their plain name
+		if (view.ends_with("[0]")) {
+			view.remove_suffix(3);
+		}
+
+		unsigned int hash{ UniformName::hashOf(view) };
+		std::size_t slot{ hash & (slots - 1) };
+		while (m_uniforms[slot].location >= 0) {
+			if (m_uniforms[slot].hash == hash) {
+				std::cerr << "| ERROR::SHADER: Uniform " << view << " has the same name hash as another uniform and can't be set\n";
+			}
+			slot = (slot + 1) & (slots - 1);
+		}
+		m_uniforms[slot].hash = hash;
+		m_uniforms[slot].location = location;
 	}
-	glUniform3f(glGetUniformLocation(m_ID, name), x, y, z);
 }
 
-void Shader::setVector3f(const char* name, const glm::vec3& value, bool useShader) {
-	if (useShader) {
-		use();
+Shader::Uniform* Shader::m_find(UniformName name) {
+	std::size_t mask{ m_uniforms.size() - 1 };
+	for (std::size_t slot{ name.hash & mask }; m_uniforms[slot].location >= 0; slot = (slot + 1) & mask) {
+		if (m_uniforms[slot].hash == name.hash) {
+			return &m_uniforms[slot];
+		}
 	}
-	glUniform3f(glGetUniformLocation(m_ID, name), value.x, value.y, value.z);
+	return nullptr;
 }
 
-void Shader::setVector4f(const char* name, float x, float y, float z, float w, bool useShader) {
+template <typename Upload>
+void Shader::m_set(UniformName name, const void* value, std::size_t size, bool useShader, Upload upload) {
 	if (useShader) {
 		use();
 	}
-	glUniform4f(glGetUniformLocation(m_ID, name), x, y, z, w);
+	Uniform* uniform{ m_uniforms.empty() ? nullptr : m_find(name) };
+	if (uniform == nullptr) {
+		return;
+	}
+	if (uniform->uploaded && std::memcmp(uniform->value, value, size) == 0) {
+		++m_skippedUploads;
+		return;
+	}
+	std::memcpy(uniform->value, value, size);
+	uniform->uploaded = true;
+	upload(uniform->location);
 }
 
-void Shader::setVector4f(const char* name, const glm::vec4& value, bool useShader) {
-	if (useShader) {
-		use();
+void Shader::m_addStage(unsigned int stage, const char* name, const char* source, const char* defines) {
+	if (source == nullptr) {
+		return;
 	}
-	glUniform4f(glGetUniformLocation(m_ID, name), value.x, value.y, value.z, value.w);
+	m_pending.stageNames[m_pending.stageCount] = name;
+	m_pending.stages[m_pending.stageCount++] = m_compileStage(stage, source, defines);
 }
 
-void Shader::setMatrix2(const char* name, const glm::mat2& matrix, bool useShader) {
-	if (useShader) {
-		use();
+unsigned int Shader::m_compileStage(unsigned int stage, const char* source, const char* defines) {
+	// #version has to stay the first line, so the defines go in between it and the rest of the source
+	std::string_view text{ source };
+	std::size_t versionEnd{ text.starts_with("#version") ? text.find('\n') : std::string_view::npos };
+	std::string version{ versionEnd != std::string_view::npos ? text.substr(0, versionEnd + 1) : std::string_view{} };
+	const char* body{ source + version.size() };
+
+	// lets a source that serves several stages tell them apart
+	const char* stageDefine{ "" };
+	switch (stage) {
+	case GL_VERTEX_SHADER:			stageDefine = "#define SHADER_STAGE_VERTEX\n"; break;
+	case GL_FRAGMENT_SHADER:		stageDefine = "#define SHADER_STAGE_FRAGMENT\n"; break;
+	case GL_GEOMETRY_SHADER:		stageDefine = "#define SHADER_STAGE_GEOMETRY\n"; break;
+	case GL_TESS_CONTROL_SHADER:	stageDefine = "#define SHADER_STAGE_TESS_CONTROL\n"; break;
+	case GL_TESS_EVALUATION_SHADER:	stageDefine = "#define SHADER_STAGE_TESS_EVALUATION\n"; break;
 	}
-	glUniformMatrix2fv(glGetUniformLocation(m_ID, name), 1, false, glm::value_ptr(matrix));
-}
 
-void Shader::setMatrix3(const char* name, const glm::mat3& matrix, bool useShader) {
-	if (useShader) {
-		use();
+	const char* sources[]{ version.c_str(), stageDefine, defines != nullptr ? defines : "", "#line 2\n", body };
+	int count{ 5 };
+	if (version.empty()) {
+		// no #version to keep in front, leave the line numbers alone
+		sources[0] = stageDefine;
+		sources[1] = defines != nullptr ? defines : "";
+		sources[2] = body;
+		count = 3;
 	}
-	glUniformMatrix3fv(glGetUniformLocation(m_ID, name), 1, false, glm::value_ptr(matrix));
+
+	unsigned int shader{ glCreateShader(stage) };
+	glShaderSource(shader, count, sources, nullptr);
+	glCompileShader(shader);
+	return shader;
 }
 
-void Shader::setMatrix4(const char* name, const glm::mat4& matrix, bool useShader) {
-	if (useShader) {
-		use();
-	}
-	glUniformMatrix4fv(glGetUniformLocation(m_ID, name), 1, false, glm::value_ptr(matrix));
+void Shader::setFloat(UniformName name, float value, bool useShader) {
+	m_set(name, &value, sizeof(value), useShader, [&](int location) { glUniform1f(location, value); });
+}
+
+void Shader::setInteger(UniformName name, int value, bool useShader) {
+	m_set(name, &value, sizeof(value), useShader, [&](int location) { glUniform1i(location, value); });
+}
+
+void Shader::setVector2f(UniformName name, float x, float y, bool useShader) {
+	setVector2f(name, glm::vec2{ x, y }, useShader);
+}
+
+void Shader::setVector2f(UniformName name, const glm::vec2& value, bool useShader) {
+	m_set(name, &value, sizeof(value), useShader, [&](int location) { glUniform2f(location, value.x, value.y); });
+}
+
+void Shader::setVector3f(UniformName name, float x, float y, float z, bool useShader) {
+	setVector3f(name, glm::vec3{ x, y, z }, useShader);
+}
+
+void Shader::setVector3f(UniformName name, const glm::vec3& value, bool useShader) {
+	m_set(name, &value, sizeof(value), useShader, [&](int location) { glUniform3f(location, value.x, value.y, value.z); });
+}
+
+void Shader::setVector4f(UniformName name, float x, float y, float z, float w, bool useShader) {
+	setVector4f(name, glm::vec4{ x, y, z, w }, useShader);
+}
+
+void Shader::setVector4f(UniformName name, const glm::vec4& value, bool useShader) {
+	m_set(name, &value, sizeof(value), useShader, [&](int location) { glUniform4f(location, value.x, value.y, value.z, value.w); });
+}
+
+void Shader::setMatrix2(UniformName name, const glm::mat2& matrix, bool useShader) {
+	m_set(name, &matrix, sizeof(matrix), useShader, [&](int location) { glUniformMatrix2fv(location, 1, false, glm::value_ptr(matrix)); });
+}
+
+void Shader::setMatrix3(UniformName name, const glm::mat3& matrix, bool useShader) {
+	m_set(name, &matrix, sizeof(matrix), useShader, [&](int location) { glUniformMatrix3fv(location, 1, false, glm::value_ptr(matrix)); });
+}
+
+void Shader::setMatrix4(UniformName name, const glm::mat4& matrix, bool useShader) {
+	m_set(name, &matrix, sizeof(matrix), useShader, [&](int location) { glUniformMatrix4fv(location, 1, false, glm::value_ptr(matrix)); });
 }
 
 unsigned int Shader::getId() {
 	return m_ID;
 }
 
+unsigned long long Shader::getSkippedUploads() {
+	return m_skippedUploads;
+}
+
 void Shader::m_checkCompileErrors(unsigned int object, std::string type) {
 	int success{};
 	char infoLog[1024];
@@ -0,0 +1,70 @@
+#include <shaderCompiler.h>
+
+#include <glad/glad.h>
+
+#include <algorithm>
+
+ShaderCompiler::ShaderCompiler() {
+	// 0xFFFFFFFF lets the implementation pick the number of threads
+	if (GLAD_GL_KHR_parallel_shader_compile) {
+		glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+		m_parallel = true;
+	}
+	else if (GLAD_GL_ARB_parallel_shader_compile) {
+		glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+		m_parallel = true;
+	}
+}
+
+std::future<bool> ShaderCompiler::submit(Shader& shader, const ShaderSources& sources, const char* defines, ProgramBinaryCache* binaryCache) {
+	m_jobs.push_back(Job{ &shader, sources, defines != nullptr ? defines : "", binaryCache });
+	Job& job{ m_jobs.back() };
+	if (m_parallel) {
+		shader.beginCompile(job.sources, job.defines.c_str(), job.binaryCache);
+		job.started = true;
+	}
+	return job.linked.get_future();
+}
+
+int ShaderCompiler::poll() {
+	if (!m_parallel) {
+		// the driver builds a program in the calling thread, so only one per call
+		if (!m_jobs.empty()) {
+			m_finish(m_jobs.front());
+			m_jobs.erase(m_jobs.begin());
+		}
+		return static_cast<int>(m_jobs.size());
+	}
+
+	// finished jobs are moved to the end and dropped, the rest keep their submission order
+	auto pending{ std::stable_partition(m_jobs.begin(), m_jobs.end(), [](Job& job) { return !job.shader->isCompileReady(); }) };
+	for (auto job{ pending }; job != m_jobs.end(); ++job) {
+		m_finish(*job);
+	}
+	m_jobs.erase(pending, m_jobs.end());
+	return static_cast<int>(m_jobs.size());
+}
+
+void ShaderCompiler::waitAll() {
+	for (Job& job : m_jobs) {
+		m_finish(job);
+	}
+	m_jobs.clear();
+}
+
+void ShaderCompiler::m_finish(Job& job) {
+	if (!job.started) {
+		job.shader->beginCompile(job.sources, job.defines.c_str(), job.binaryCache);
+		job.started = true;
+	}
+	job.linked.set_value(job.shader->finishCompile());
+	++m_finished;
+}
+
+bool ShaderCompiler::isParallel() {
+	return m_parallel;
+}
+
+unsigned int ShaderCompiler::getFinishedCount() {
+	return m_finished;
+}
\ No newline at end of file
@@ -0,0 +1,113 @@
+#include <shaderWatcher.h>
+
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#endif
+
+ShaderWatcher::~ShaderWatcher() {
+#ifdef __linux__
+	if (m_fd >= 0) {
+		close(m_fd);
+	}
+#endif
+}
+
+#ifdef __linux__
+bool ShaderWatcher::watch(const std::string& path) {
+	if (m_fd < 0) {
+		m_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		if (m_fd < 0) {
+			std::cerr << "| ERROR::SHADER_WATCHER: Failed to initialise inotify: " << std::strerror(errno) << '\n';
+			return false;
+		}
+	}
+
+	std::filesystem::path file{ std::filesystem::absolute(path) };
+	std::string directory{ file.parent_path().string() };
+	std::string name{ file.filename().string() };
+	// a finished write or a file renamed into place, a plain modify could still be halfway through
+	int descriptor{ inotify_add_watch(m_fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) };
+	if (descriptor < 0) {
+		std::cerr << "| ERROR::SHADER_WATCHER: Failed to watch " << directory << ": " << std::strerror(errno) << '\n';
+		return false;
+	}
+	// inotify hands out one descriptor per directory, no matter how often it is added
+	bool known{};
+	for (const Watch& watch : m_watches) {
+		known = known || watch.descriptor == descriptor;
+	}
+	if (!known) {
+		m_watches.push_back(Watch{ descriptor, directory });
+	}
+	m_files.emplace_back(directory, name);
+	return true;
+}
+
+bool ShaderWatcher::poll() {
+	if (m_fd < 0) {
+		return false;
+	}
+
+	bool changed{};
+	alignas(inotify_event) char buffer[4096];
+	for (;;) {
+		ssize_t length{ read(m_fd, buffer, sizeof(buffer)) };
+		if (length <= 0) {
+			break;
+		}
+		for (ssize_t offset{ 0 }; offset < length;) {
+			const inotify_event* event{ reinterpret_cast<const inotify_event*>(buffer + offset) };
+			offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+			if (event->len == 0) {
+				continue;
+			}
+			for (const Watch& watch : m_watches) {
+				if (watch.descriptor != event->wd) {
+					continue;
+				}
+				for (const auto& [directory, name] : m_files) {
+					changed = changed || (directory == watch.directory && name == event->name);
+				}
+			}
+		}
+	}
+	return changed;
+}
+#else
+bool ShaderWatcher::watch(const std::string& path) {
+	std::cerr << "| ERROR::SHADER_WATCHER: Watching " << path << " needs inotify, which is only available on Linux\n";
+	return false;
+}
+
+bool ShaderWatcher::poll() {
+	return false;
+}
+#endif
+
+bool ShaderWatcher::readSource(const std::string& path, std::string& source) {
+	std::ifstream file{ path };
+	if (!file) {
+		std::cerr << "| ERROR::SHADER_WATCHER: Failed to read " << path << '\n';
+		return false;
+	}
+	std::ostringstream text{};
+	text << file.rdbuf();
+	source = text.str();
+
+	// the GLSL of a CPP_SHADER_INCLUDE file sits between R"( and the last )"
+	std::size_t begin{ source.find("R\"(") };
+	std::size_t end{ source.rfind(")\"") };
+	if (begin != std::string::npos && end != std::string::npos && end > begin) {
+		source = source.substr(begin + 3, end - begin - 3);
+	}
+	return true;
+}
\ No newline at end of file
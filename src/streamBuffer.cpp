@@ -0,0 +1,140 @@
+#include <streamBuffer.h>
+
+#include <iostream>
+
+void StreamBuffer::create(unsigned int target, std::size_t regionSize, unsigned int regionCount) {
+	m_target = target;
+	// keep every region aligned so it can be bound as any kind of buffer range
+	m_regionSize = (regionSize + 255) & ~static_cast<std::size_t>(255);
+	m_regionCount = regionCount < 1 ? 1 : (regionCount > MAX_REGIONS ? MAX_REGIONS : regionCount);
+	m_current = 0;
+	m_persistent = GLAD_GL_ARB_buffer_storage != 0;
+
+	glGenBuffers(1, &m_ID);
+	glBindBuffer(m_target, m_ID);
+	if (m_persistent) {
+		GLbitfield flags{ GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT };
+		glBufferStorage(m_target, m_regionSize * m_regionCount, nullptr, flags);
+		m_persistentPtr = static_cast<unsigned char*>(glMapBufferRange(m_target, 0, m_regionSize * m_regionCount, flags));
+		if (m_persistentPtr == nullptr) {
+			std::cerr << "| ERROR::STREAM_BUFFER: Persistent mapping failed, falling back to orphaning\n";
+			glDeleteBuffers(1, &m_ID);
+			glGenBuffers(1, &m_ID);
+			glBindBuffer(m_target, m_ID);
+			m_persistent = false;
+		}
+	}
+	if (!m_persistent) {
+		glBufferData(m_target, m_regionSize * m_regionCount, nullptr, GL_STREAM_DRAW);
+	}
+	glBindBuffer(m_target, 0);
+}
+
+void StreamBuffer::destroy() {
+	m_deleteFences();
+	if (m_persistentPtr != nullptr) {
+		glBindBuffer(m_target, m_ID);
+		glUnmapBuffer(m_target);
+		glBindBuffer(m_target, 0);
+		m_persistentPtr = nullptr;
+	}
+	glDeleteBuffers(1, &m_ID);
+	m_ID = 0;
+}
+
+void* StreamBuffer::map() {
+	m_lastMapStalled = false;
+	std::size_t offset{ m_current * m_regionSize };
+
+	if (m_persistent) {
+		// with enough regions in flight the fence has long been signalled,
+		// waiting here means the GPU is more than regionCount - 1 frames behind
+		if (!m_isRegionFree(m_current)) {
+			m_lastMapStalled = true;
+			++m_stallCount;
+			m_waitForRegion(m_current);
+		}
+		return m_persistentPtr + offset;
+	}
+
+	glBindBuffer(m_target, m_ID);
+	GLbitfield flags{ GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT };
+	if (!m_isRegionFree(m_current)) {
+		// the GPU still reads this region, give the driver fresh storage instead of waiting
+		glBufferData(m_target, m_regionSize * m_regionCount, nullptr, GL_STREAM_DRAW);
+		m_deleteFences();
+		++m_orphanCount;
+	}
+	return glMapBufferRange(m_target, offset, m_regionSize, flags);
+}
+
+std::size_t StreamBuffer::unmap() {
+	if (!m_persistent) {
+		glUnmapBuffer(m_target);
+		glBindBuffer(m_target, 0);
+	}
+	return m_current * m_regionSize;
+}
+
+void StreamBuffer::fence() {
+	if (m_fences[m_current] != nullptr) {
+		glDeleteSync(m_fences[m_current]);
+	}
+	m_fences[m_current] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	m_current = (m_current + 1) % m_regionCount;
+}
+
+bool StreamBuffer::m_isRegionFree(unsigned int region) {
+	if (m_fences[region] == nullptr) {
+		return true;
+	}
+	GLenum result{ glClientWaitSync(m_fences[region], 0, 0) };
+	if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED) {
+		glDeleteSync(m_fences[region]);
+		m_fences[region] = nullptr;
+		return true;
+	}
+	return false;
+}
+
+void StreamBuffer::m_waitForRegion(unsigned int region) {
+	constexpr GLuint64 timeout{ 1000000000 }; // one second in nanoseconds
+	GLenum result{ GL_TIMEOUT_EXPIRED };
+	while (result == GL_TIMEOUT_EXPIRED) {
+		result = glClientWaitSync(m_fences[region], GL_SYNC_FLUSH_COMMANDS_BIT, timeout);
+	}
+	if (result == GL_WAIT_FAILED) {
+		std::cerr << "| ERROR::STREAM_BUFFER: glClientWaitSync failed\n";
+	}
+	glDeleteSync(m_fences[region]);
+	m_fences[region] = nullptr;
+}
+
+void StreamBuffer::m_deleteFences() {
+	for (GLsync& fence : m_fences) {
+		if (fence != nullptr) {
+			glDeleteSync(fence);
+			fence = nullptr;
+		}
+	}
+}
+
+unsigned int StreamBuffer::getId() {
+	return m_ID;
+}
+
+bool StreamBuffer::isPersistent() {
+	return m_persistent;
+}
+
+bool StreamBuffer::lastMapStalled() {
+	return m_lastMapStalled;
+}
+
+unsigned int StreamBuffer::getStallCount() {
+	return m_stallCount;
+}
+
+unsigned int StreamBuffer::getOrphanCount() {
+	return m_orphanCount;
+}
\ No newline at end of file
@@ -0,0 +1,244 @@
+#include <trace.h>
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+namespace {
+	struct Zone {
+		const char* name{};
+		// nanoseconds since the trace started
+		long long start{};
+		long long end{};
+	};
+
+	// single writer ring, the owning thread publishes every zone with the release store of head
+	struct Ring {
+		std::unique_ptr<Zone[]> zones{ new Zone[Trace::RING_CAPACITY] };
+		std::atomic<unsigned long long> head{};
+		int thread{};
+	};
+
+	// pending GPU zones of one frame, two timestamp queries per zone, made for MAX_GPU_ZONES zones by start()
+	struct QueryFrame {
+		std::vector<unsigned int> queries{};
+		std::vector<const char*> names{};
+		int used{};
+	};
+
+	std::atomic<bool> enabled{};
+	std::chrono::steady_clock::time_point origin{};
+
+	// rings of the threads that recorded a zone, never freed since the trace outlives the threads
+	std::atomic<Ring*> rings[Trace::MAX_THREADS]{};
+	std::atomic<int> ringCount{};
+	thread_local Ring* threadRing{};
+	thread_local bool threadRegistered{};
+
+	// GPU state, only touched by the thread that owns the context
+	Ring gpuRing{};
+	QueryFrame queryFrames[Trace::QUERY_LATENCY]{};
+	int queryFrame{};
+	long long gpuOffset{};
+	unsigned long long droppedGpuZones{};
+	unsigned long long overflowGpuZones{};
+
+	long long now() {
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - origin).count();
+	}
+
+	Ring* currentRing() {
+		if (!threadRegistered) {
+			threadRegistered = true;
+			int index{ ringCount.fetch_add(1, std::memory_order_relaxed) };
+			if (index < Trace::MAX_THREADS) {
+				threadRing = new Ring{};
+				threadRing->thread = index;
+				rings[index].store(threadRing, std::memory_order_release);
+			}
+		}
+		return threadRing;
+	}
+
+	void record(Ring& ring, const Zone& zone) {
+		unsigned long long head{ ring.head.load(std::memory_order_relaxed) };
+		ring.zones[head % Trace::RING_CAPACITY] = zone;
+		ring.head.store(head + 1, std::memory_order_release);
+	}
+
+	// moves the finished GPU zones of the frame into the GPU ring, drops the ones that aren't ready unless waiting is allowed
+	void collect(QueryFrame& frame, bool wait) {
+		for (int i{ 0 }; i < frame.used; ++i) {
+			unsigned int begin{ frame.queries[2 * i] };
+			unsigned int end{ frame.queries[2 * i + 1] };
+			GLint available{ GL_TRUE };
+			if (!wait) {
+				glGetQueryObjectiv(end, GL_QUERY_RESULT_AVAILABLE, &available);
+			}
+			if (available == GL_FALSE) {
+				++droppedGpuZones;
+				continue;
+			}
+			GLuint64 beginTime{};
+			GLuint64 endTime{};
+			glGetQueryObjectui64v(begin, GL_QUERY_RESULT, &beginTime);
+			glGetQueryObjectui64v(end, GL_QUERY_RESULT, &endTime);
+			record(gpuRing, Zone{ frame.names[i], static_cast<long long>(beginTime) + gpuOffset, static_cast<long long>(endTime) + gpuOffset });
+		}
+		frame.used = 0;
+	}
+
+	void writeZones(std::ofstream& file, const Ring& ring, bool& first, unsigned long long& written) {
+		unsigned long long head{ ring.head.load(std::memory_order_acquire) };
+		unsigned long long count{ std::min<unsigned long long>(head, Trace::RING_CAPACITY) };
+		for (unsigned long long i{ head - count }; i < head; ++i) {
+			const Zone& zone{ ring.zones[i % Trace::RING_CAPACITY] };
+			file << (first ? "\n" : ",\n") << "{\"name\":\"" << zone.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << ring.thread
+				<< ",\"ts\":" << zone.start / 1000.0 << ",\"dur\":" << (zone.end - zone.start) / 1000.0 << '}';
+			first = false;
+		}
+		written += count;
+	}
+}
+
+namespace Trace {
+#ifdef ENABLE_TRACING
+	bool start() {
+		origin = std::chrono::steady_clock::now();
+		// GL_TIMESTAMP counts from an arbitrary point, the offset moves it onto the CPU clock
+		GLint64 gpuNow{};
+		glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+		gpuOffset = now() - gpuNow;
+		gpuRing.thread = MAX_THREADS;
+		for (QueryFrame& frame : queryFrames) {
+			if (frame.queries.empty()) {
+				frame.queries.resize(2 * MAX_GPU_ZONES);
+				frame.names.resize(MAX_GPU_ZONES);
+				glGenQueries(static_cast<int>(frame.queries.size()), frame.queries.data());
+			}
+		}
+		enabled.store(true, std::memory_order_relaxed);
+		return true;
+	}
+#else
+	bool start() {
+		std::cerr << "| ERROR::TRACE: This build has no tracing, configure it with --tracing=y\n";
+		return false;
+	}
+#endif
+
+	void endFrame() {
+		if (!isEnabled()) {
+			return;
+		}
+		// the oldest frame is reused next, QUERY_LATENCY - 1 frames after its queries were issued
+		queryFrame = (queryFrame + 1) % QUERY_LATENCY;
+		collect(queryFrames[queryFrame], false);
+	}
+
+	bool stop(const std::string& path) {
+		if (!isEnabled()) {
+			return false;
+		}
+		enabled.store(false, std::memory_order_relaxed);
+
+		// nothing is rendered anymore, so waiting for the last frames costs nothing
+		for (int i{ 1 }; i <= QUERY_LATENCY; ++i) {
+			collect(queryFrames[(queryFrame + i) % QUERY_LATENCY], true);
+		}
+		for (QueryFrame& frame : queryFrames) {
+			if (!frame.queries.empty()) {
+				glDeleteQueries(static_cast<int>(frame.queries.size()), frame.queries.data());
+				frame.queries.clear();
+				frame.names.clear();
+			}
+		}
+
+		std::ofstream file{ path };
+		if (!file) {
+			std::cerr << "| ERROR::TRACE: Failed to open " << path << '\n';
+			return false;
+		}
+		file << std::fixed << std::setprecision(3) << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+		bool first{ true };
+		unsigned long long cpuZones{};
+		unsigned long long gpuZones{};
+		int threads{ std::min(ringCount.load(std::memory_order_relaxed), MAX_THREADS) };
+		for (int i{ 0 }; i < threads; ++i) {
+			const Ring* ring{ rings[i].load(std::memory_order_acquire) };
+			if (ring == nullptr) {
+				continue;
+			}
+			file << (first ? "\n" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << i
+				<< ",\"args\":{\"name\":\"" << (i == 0 ? "render thread" : "thread") << ' ' << i << "\"}}";
+			first = false;
+			writeZones(file, *ring, first, cpuZones);
+		}
+		file << (first ? "\n" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << MAX_THREADS << ",\"args\":{\"name\":\"GPU\"}}";
+		first = false;
+		writeZones(file, gpuRing, first, gpuZones);
+		file << "\n]}\n";
+
+		std::cout << "| TRACE: " << cpuZones << " CPU and " << gpuZones << " GPU zones written to " << path;
+		if (droppedGpuZones > 0) {
+			std::cout << ", " << droppedGpuZones << " GPU zones dropped because their queries weren't ready";
+		}
+		if (overflowGpuZones > 0) {
+			std::cout << ", " << overflowGpuZones << " GPU zones dropped past " << MAX_GPU_ZONES << " in a frame";
+		}
+		std::cout << '\n';
+		return true;
+	}
+
+	bool isEnabled() {
+		return enabled.load(std::memory_order_relaxed);
+	}
+
+	CpuZone::CpuZone(const char* name)
+		: m_name{ name }
+	{
+		if (isEnabled()) {
+			// threads are numbered by their first zone to open, not to close, so the render thread's frame zone makes it thread 0
+			currentRing();
+			m_start = now();
+		}
+	}
+
+	CpuZone::~CpuZone() {
+		if (m_start < 0) {
+			return;
+		}
+		Ring* ring{ currentRing() };
+		if (ring != nullptr) {
+			record(*ring, Zone{ m_name, m_start, now() });
+		}
+	}
+
+	GpuZone::GpuZone(const char* name) {
+		if (!isEnabled()) {
+			return;
+		}
+		QueryFrame& frame{ queryFrames[queryFrame] };
+		if (frame.used == MAX_GPU_ZONES) {
+			++overflowGpuZones;
+			return;
+		}
+		m_query = frame.used++;
+		frame.names[m_query] = name;
+		glQueryCounter(frame.queries[2 * m_query], GL_TIMESTAMP);
+	}
+
+	GpuZone::~GpuZone() {
+		if (m_query < 0) {
+			return;
+		}
+		glQueryCounter(queryFrames[queryFrame].queries[2 * m_query + 1], GL_TIMESTAMP);
+	}
+}
\ No newline at end of file
@@ -4,10 +4,79 @@ add_rules("mode.debug", "mode.release")
 add_requires("glfw", {alias = "glfw"})
 add_requires("opengl")
 
+-- Scoped CPU and GPU timing zones written as a Chrome trace with --trace (see trace.h)
+option("tracing")
+    set_default(false)
+    set_showmenu(true)
+    set_description("Compile the TRACE_ZONE instrumentation into the renderer")
+    add_defines("ENABLE_TRACING")
+option_end()
+
+-- Abort when the render loop allocates on the heap after warm-up (see allocationCheck.h), always on in debug builds
+option("alloccheck")
+    set_default(false)
+    set_showmenu(true)
+    set_description("Check that the render loop runs without heap allocations")
+    add_defines("ENABLE_ALLOCATION_CHECK")
+option_end()
+
+-- The CPU evaluator has no dispatch at runtime, built for AVX2 and FMA the binaries need a CPU with both
+-- and refuse to start without them. Turned off the evaluator falls back to SSE2 (see simd.h)
+option("avx2")
+    set_default(true)
+    set_showmenu(true)
+    set_description("Build the CPU evaluator for AVX2 and FMA instead of SSE2")
+option_end()
+
+-- CPU evaluation of the surfaces, usable without a GL context
+target("surfaces")
+    set_kind("static")
+    set_languages("c++20")
+
+    add_includedirs("src/Header Files", {public = true})
+    add_includedirs("src/Includes", {public = true})
+
+    add_files("src/Evaluator/*.cpp")
+
+    -- the evaluator picks the widest vector unit it is compiled for (see simd.h)
+    if has_config("avx2") then
+        add_vectorexts("avx2", "fma")
+    end
+
+    if is_plat("linux") then
+        add_syslinks("pthread", {public = true})
+    end
+
+-- Throughput and accuracy benchmark for the CPU evaluator
+target("surfaces-bench")
+    set_kind("binary")
+    set_languages("c++20")
+    add_deps("surfaces")
+
+    add_files("src/Tools/surfacesBench.cpp")
+
+    -- compiled like the library, so the inline code the two share is the same in both
+    if has_config("avx2") then
+        add_vectorexts("avx2", "fma")
+    end
+
+-- Concurrency stress test for the job system, run it again after changing jobSystem.cpp
+target("jobsystem-stress")
+    set_kind("binary")
+    set_languages("c++20")
+    add_deps("surfaces")
+
+    add_files("src/Tools/jobSystemStress.cpp")
+
+    if has_config("avx2") then
+        add_vectorexts("avx2", "fma")
+    end
+
 -- Define the target (your project)
 target("glMathematical-Surfaces")
     set_kind("binary")  -- or 'static', 'shared', etc.
     set_languages("c++20")
+    add_deps("surfaces")
 
     -- Set the include directories
     add_includedirs("src/Header Files")
@@ -19,9 +88,20 @@ target("glMathematical-Surfaces")
     add_files("src/*.c")
 
     -- Link against OpenGL (system library)
-    add_syslinks("opengl32")  -- For Windows
-    -- add_syslinks("GL")  -- For Linux or macOS
+    if is_plat("windows") then
+        add_syslinks("opengl32")
+    elseif is_plat("linux") then
+        -- EGL provides the context for --headless on machines without a display (see headless.h)
+        add_syslinks("EGL", "GL", "dl", "pthread")
+        add_defines("HAS_EGL")
+    elseif is_plat("macosx") then
+        add_frameworks("OpenGL")
+    end
 
     -- Link against GLFW (using the alias we set earlier)
     add_packages("glfw")
 
+    add_options("tracing", "alloccheck")
+    if is_mode("debug") then
+        add_defines("ENABLE_ALLOCATION_CHECK")
+    end
\ No newline at end of file